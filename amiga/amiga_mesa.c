@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 #include <GL/amiga_mesa.h>
 #include "amiga_mesa_def.h"
@@ -48,7 +49,9 @@
 #include "tnl/t_pipeline.h"
 
 
+#include <proto/exec.h>
 #include <proto/cybergraphics.h>
+#include <exec/execbase.h>
 #include <cybergraphics/cybergraphics.h>
 
 
@@ -98,7 +101,7 @@ static GLvisual* amesa_create_visual(AMesaContext *a_ctx) {
 	case PIXFMT_BGR15PC:
 		indexBits = 0;
 		redBits = 5;
-		greenBits = 6;
+		greenBits = 5;
 		blueBits = 5;
 		rgb_flag = GL_TRUE;
 		break;
@@ -173,16 +176,27 @@ void amesa_destroy_context(AMesaContext *a_ctx) {
 		amesa_display_shutdown(a_ctx);
 
 		if (a_ctx->gl_ctx) {
-			_swsetup_DestroyContext(a_ctx->gl_ctx);
-			_tnl_DestroyContext(a_ctx->gl_ctx);
-			_ac_DestroyContext(a_ctx->gl_ctx);
-			_swrast_DestroyContext(a_ctx->gl_ctx);
-
-			_mesa_destroy_framebuffer(a_ctx->gl_buffer);
+			// The helper modules are created right after the buffer, a
+			// context that failed before that has none.
+			if (a_ctx->gl_buffer) {
+				_swsetup_DestroyContext(a_ctx->gl_ctx);
+				_tnl_DestroyContext(a_ctx->gl_ctx);
+				_ac_DestroyContext(a_ctx->gl_ctx);
+				_swrast_DestroyContext(a_ctx->gl_ctx);
+
+				_mesa_destroy_framebuffer(a_ctx->gl_buffer);
+			}
 			_mesa_destroy_context(a_ctx->gl_ctx);
+		}
+
+		if (a_ctx->gl_visual) {
 			_mesa_destroy_visual(a_ctx->gl_visual);
 		}
 
+		if (a_ctx->offscreen_bitmap) {
+			FreeBitMap(a_ctx->offscreen_bitmap);
+		}
+
 		FreeVec(a_ctx);
 		a_ctx = NULL;
 	}
@@ -234,7 +248,102 @@ void amesa_swap_buffers(AMesaContext *ctx) {
 	}
 }
 
-AMesaContext* amesa_create_context(struct Window *window) {
+void amesa_damage_window(AMesaContext *a_ctx) {
+	if (a_ctx) {
+		amesa_display_damage(a_ctx);
+	}
+}
+
+GLboolean amesa_set_direct_render(AMesaContext *a_ctx, GLboolean enable) {
+	if (a_ctx) {
+		return amesa_display_set_direct(a_ctx, enable);
+	}
+
+	return GL_FALSE;
+}
+
+/*
+ * Create the Mesa visual, context and framebuffer for an Amiga context
+ * whose pixel format and drawable size have already been set up.
+ */
+static GLboolean amesa_create_gl_context(AMesaContext *a_ctx) {
+	switch (a_ctx->fmt) {
+	case PIXFMT_ARGB32:
+	case PIXFMT_BGRA32:
+	case PIXFMT_RGBA32:
+		a_ctx->pixel_bytes = 4;
+		break;
+	case PIXFMT_RGB15:
+	case PIXFMT_RGB15PC:
+	case PIXFMT_BGR15PC:
+	case PIXFMT_RGB16:
+	case PIXFMT_RGB16PC:
+	case PIXFMT_BGR16PC:
+		a_ctx->pixel_bytes = 2;
+		break;
+	default:
+		_mesa_error(NULL, GL_INVALID_VALUE, "Only 15/16-bit and 32-bit pixel formats are supported by OpenGL");
+		return GL_FALSE;
+	}
+
+	// Rows are kept a whole number of longwords for CopyMemQuick().
+	a_ctx->pitch = ((a_ctx->width * a_ctx->pixel_bytes) + 3) & ~3;
+
+	_mesa_debug(NULL, "Creating Mesa Visual...\n");
+	a_ctx->gl_visual = amesa_create_visual(a_ctx);
+	if (!a_ctx->gl_visual) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Could not create the GL Visual");
+		return GL_FALSE;
+	}
+
+	// Allocate a new Mesa context
+	a_ctx->gl_ctx = (void*)_mesa_create_context(a_ctx->gl_visual, NULL, (void*) a_ctx, GL_FALSE);
+	if (!a_ctx->gl_ctx) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Could not create the GL Context");
+		return GL_FALSE;
+	}
+
+	_mesa_enable_sw_extensions(a_ctx->gl_ctx);
+	_mesa_enable_1_3_extensions(a_ctx->gl_ctx);
+
+	// OpenGL 1.4 not enabled.
+	// Mesa 4.1 software paths incomplete for custom back buffers.
+	//_mesa_enable_1_4_extensions(a_ctx->gl_ctx);
+
+	// The 32-bit pixels hold alpha themselves, so there is no software
+	// alpha buffer for swrast (or the driver rasterizers) to keep in step.
+	_mesa_debug(NULL, "Creating Mesa buffer...\n");
+	a_ctx->gl_buffer = _mesa_create_framebuffer(a_ctx->gl_visual, a_ctx->gl_visual->depthBits > 0, a_ctx->gl_visual->stencilBits > 0,
+			a_ctx->gl_visual->accumRedBits > 0, GL_FALSE);
+	if (!a_ctx->gl_buffer) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Could not create the GL Buffer");
+		return GL_FALSE;
+	}
+
+	// Without an FPU every float in triangle setup traps into emulation.
+	a_ctx->fixed_point = !(SysBase->AttnFlags & (AFF_68881 | AFF_68882 | AFF_FPU40));
+
+	// Initialize the software render and helper modules.
+	_swrast_CreateContext(a_ctx->gl_ctx);
+	_ac_CreateContext(a_ctx->gl_ctx);
+	_tnl_CreateContext(a_ctx->gl_ctx);
+	_swsetup_CreateContext(a_ctx->gl_ctx);
+
+	if (!amesa_display_init(a_ctx)) {
+		return GL_FALSE;
+	}
+
+	// Install swsetup for the tnl->Driver.Render.
+	amesa_display_wakeup(a_ctx);
+
+	return GL_TRUE;
+}
+
+/*
+ * Create a context for a window, rendering at the given size (0 for the
+ * size of the window).
+ */
+static AMesaContext* amesa_create_window_context(struct Window *window, GLuint render_width, GLuint render_height) {
 	AMesaContext *a_ctx = NULL;
 	struct Screen* screen;
 
@@ -249,6 +358,7 @@ AMesaContext* amesa_create_context(struct Window *window) {
 	a_ctx->hardware_window = window;
 	if (!a_ctx->hardware_window) {
 		_mesa_error(NULL, GL_INVALID_VALUE, "Cannot create an Amiga context without an Intuition window");
+		amesa_destroy_context(a_ctx);
 		return NULL;
 	}
 
@@ -256,62 +366,237 @@ AMesaContext* amesa_create_context(struct Window *window) {
 	screen = a_ctx->hardware_window->WScreen;
 	if (!IsCyberModeID(GetVPModeID(&screen->ViewPort))) {
 		_mesa_error(NULL, GL_INVALID_VALUE, "The Intuition window is not CGX native");
+		amesa_destroy_context(a_ctx);
 		return NULL;
 	}
 
 	a_ctx->fmt = GetCyberMapAttr(a_ctx->hardware_window->RPort->BitMap, CYBRMATTR_PIXFMT);
-	if ((a_ctx->fmt != PIXFMT_ARGB32) && (a_ctx->fmt != PIXFMT_BGRA32) && (a_ctx->fmt != PIXFMT_RGBA32)) {
-		_mesa_error(NULL, GL_INVALID_VALUE, "Only 32-bit pixel formats are supported by OpenGL");
-		return NULL;
-	}
 
-	a_ctx->width = a_ctx->hardware_window->Width -
+	a_ctx->display_width = a_ctx->hardware_window->Width -
 	                (a_ctx->hardware_window->BorderLeft + a_ctx->hardware_window->BorderRight);
-	a_ctx->height = a_ctx->hardware_window->Height -
+	a_ctx->display_height = a_ctx->hardware_window->Height -
 	                (a_ctx->hardware_window->BorderTop + a_ctx->hardware_window->BorderBottom);
-	a_ctx->pitch = (a_ctx->width * 4);
 
-	_mesa_debug(NULL, "Creating Mesa Visual...\n");
-	a_ctx->gl_visual = amesa_create_visual(a_ctx);
-	if (!a_ctx->gl_visual) {
-		_mesa_error(NULL, GL_INVALID_VALUE, "Could not create the GL Visual");
+	// Rendering at a lower resolution gets scaled up on swap.
+	a_ctx->width = render_width ? render_width : a_ctx->display_width;
+	a_ctx->height = render_height ? render_height : a_ctx->display_height;
+	if ((a_ctx->width > a_ctx->display_width) || (a_ctx->height > a_ctx->display_height)) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "The render size cannot be larger than the window");
+		amesa_destroy_context(a_ctx);
 		return NULL;
 	}
 
-	// Allocate a new Mesa context
-	a_ctx->gl_ctx = (void*)_mesa_create_context(a_ctx->gl_visual, NULL, (void*) a_ctx, GL_FALSE);
-	if (!a_ctx->gl_ctx) {
-		_mesa_error(NULL, GL_INVALID_VALUE, "Could not create the GL Context");
+	a_ctx->rast_port = a_ctx->hardware_window->RPort;
+	a_ctx->dest_x = a_ctx->hardware_window->BorderLeft;
+	a_ctx->dest_y = a_ctx->hardware_window->BorderTop;
+
+	if (!amesa_create_gl_context(a_ctx)) {
+		amesa_destroy_context(a_ctx);
 		return NULL;
 	}
 
-	_mesa_enable_sw_extensions(a_ctx->gl_ctx);
-	_mesa_enable_1_3_extensions(a_ctx->gl_ctx);
+	return a_ctx;
+}
 
-	// OpenGL 1.4 not enabled.
-	// Mesa 4.1 software paths incomplete for custom back buffers.
-	//_mesa_enable_1_4_extensions(a_ctx->gl_ctx);
+AMesaContext* amesa_create_context(struct Window *window) {
+	return amesa_create_window_context(window, 0, 0);
+}
 
-	_mesa_debug(NULL, "Creating Mesa buffer...\n");
-	a_ctx->gl_buffer = _mesa_create_framebuffer(a_ctx->gl_visual, a_ctx->gl_visual->depthBits > 0, a_ctx->gl_visual->stencilBits > 0,
-			a_ctx->gl_visual->accumRedBits > 0, a_ctx->gl_visual->alphaBits > 0);
-	if (!a_ctx->gl_buffer) {
-		_mesa_error(NULL, GL_INVALID_VALUE, "Could not create the GL Buffer");
+AMesaContext* amesa_create_offscreen_context(GLuint width, GLuint height, GLuint format) {
+	AMesaContext *a_ctx = NULL;
+
+	_mesa_debug(NULL, "Creating offscreen Amiga context...\n");
+
+	if ((width == 0) || (height == 0)) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Cannot create an offscreen context without a size");
 		return NULL;
 	}
 
-	// Initialize the software render and helper modules.
-	_swrast_CreateContext(a_ctx->gl_ctx);
-	_ac_CreateContext(a_ctx->gl_ctx);
-	_tnl_CreateContext(a_ctx->gl_ctx);
-	_swsetup_CreateContext(a_ctx->gl_ctx);
+	a_ctx = (AMesaContext*)AllocVec(sizeof(AMesaContext), MEMF_PUBLIC|MEMF_CLEAR);
+	if (!a_ctx) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate an Amiga context");
+		return NULL;
+	}
 
-	if (!amesa_display_init(a_ctx)) {
+	a_ctx->fmt = format;
+	a_ctx->width = width;
+	a_ctx->height = height;
+	a_ctx->display_width = width;
+	a_ctx->display_height = height;
+
+	// Ask for a surface in exactly the requested format, so that swaps
+	// go through the same conversion as a window on such a screen.
+	a_ctx->offscreen_bitmap = AllocBitMap(width, height, 32,
+			BMF_CLEAR|BMF_MINPLANES|BMF_SPECIALFMT|SHIFT_PIXFMT(format), NULL);
+	if (!a_ctx->offscreen_bitmap) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the offscreen bitmap");
+		amesa_destroy_context(a_ctx);
 		return NULL;
 	}
 
-	// Install swsetup for the tnl->Driver.Render.
-	_swsetup_Wakeup(a_ctx->gl_ctx);
+	if (GetCyberMapAttr(a_ctx->offscreen_bitmap, CYBRMATTR_PIXFMT) != format) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "The offscreen bitmap format is not supported");
+		amesa_destroy_context(a_ctx);
+		return NULL;
+	}
+
+	InitRastPort(&a_ctx->offscreen_rport);
+	a_ctx->offscreen_rport.BitMap = a_ctx->offscreen_bitmap;
+
+	a_ctx->rast_port = &a_ctx->offscreen_rport;
+	a_ctx->dest_x = 0;
+	a_ctx->dest_y = 0;
+
+	if (!amesa_create_gl_context(a_ctx)) {
+		amesa_destroy_context(a_ctx);
+		return NULL;
+	}
+
+	return a_ctx;
+}
+
+// Tag data is pointer sized on the host.
+#ifdef AMESA_HOST
+typedef IPTR amesa_tag_data;
+#else
+typedef ULONG amesa_tag_data;
+#endif
+
+AMesaContext* amesa_create_context_taglist(const struct TagItem *tags) {
+	struct Window *window = (struct Window*) GetTagData(AMESA_Window, 0, tags);
+	GLuint buffers = GetTagData(AMESA_Buffers, 1, tags);
+	GLboolean direct = GetTagData(AMESA_DirectRender, GL_FALSE, tags);
+	GLboolean async = GetTagData(AMESA_AsyncSwap, GL_FALSE, tags);
+	GLuint depth_flip = GetTagData(AMESA_DepthFlip, AMESA_DEPTHFLIP_NONE, tags);
+	GLint fixed_point = (GLint) GetTagData(AMESA_FixedPoint, (amesa_tag_data) -1, tags);
+	GLuint tex_subdivide = GetTagData(AMESA_TexSubdivide, 0, tags);
+	AMesaContext *a_ctx = NULL;
+
+	if (window) {
+		a_ctx = amesa_create_window_context(window, GetTagData(AMESA_RenderWidth, 0, tags),
+				GetTagData(AMESA_RenderHeight, 0, tags));
+	} else {
+		a_ctx = amesa_create_offscreen_context(GetTagData(AMESA_Width, 0, tags),
+				GetTagData(AMESA_Height, 0, tags),
+				GetTagData(AMESA_PixelFormat, PIXFMT_ARGB32, tags));
+	}
+
+	if (!a_ctx) {
+		return NULL;
+	}
 
+	if (buffers > 1) {
+		if (!amesa_display_open_flip(a_ctx, buffers)) {
+			amesa_destroy_context(a_ctx);
+			return NULL;
+		}
+	} else if (direct) {
+		if (!amesa_display_set_direct(a_ctx, GL_TRUE)) {
+			amesa_destroy_context(a_ctx);
+			return NULL;
+		}
+	}
+
+	if (async) {
+		if (!amesa_display_open_async(a_ctx)) {
+			amesa_destroy_context(a_ctx);
+			return NULL;
+		}
+	}
+
+	if (depth_flip != AMESA_DEPTHFLIP_NONE) {
+		if (!amesa_display_set_depth_flip(a_ctx, depth_flip)) {
+			amesa_destroy_context(a_ctx);
+			return NULL;
+		}
+	}
+
+	// Left to the CPU detection unless given.
+	if (fixed_point >= 0) {
+		amesa_display_set_fixed_point(a_ctx, (GLboolean) fixed_point);
+	}
+
+	if (tex_subdivide) {
+		if (!amesa_display_set_tex_subdivide(a_ctx, tex_subdivide)) {
+			amesa_destroy_context(a_ctx);
+			return NULL;
+		}
+	}
+
+	return a_ctx;
+}
+
+AMesaContext* amesa_create_context_tags(Tag tag1, ...) {
+	AMesaContext *a_ctx;
+	struct TagItem *tags;
+	GLuint count = 1;
+	va_list args;
+
+	// Copy the tags into a real tag list, the arguments can't be walked
+	// in place on every ABI.
+	va_start(args, tag1);
+	for (Tag tag = tag1; tag != TAG_DONE; tag = va_arg(args, Tag)) {
+		(void) va_arg(args, amesa_tag_data);
+		count++;
+	}
+	va_end(args);
+
+	tags = (struct TagItem*) AllocVec(count * sizeof(struct TagItem), MEMF_PUBLIC|MEMF_CLEAR);
+	if (!tags) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the tag list");
+		return NULL;
+	}
+
+	count = 0;
+	va_start(args, tag1);
+	for (Tag tag = tag1; tag != TAG_DONE; tag = va_arg(args, Tag)) {
+		tags[count].ti_Tag = tag;
+		tags[count].ti_Data = va_arg(args, amesa_tag_data);
+		count++;
+	}
+	va_end(args);
+	tags[count].ti_Tag = TAG_DONE;
+
+	a_ctx = amesa_create_context_taglist(tags);
+
+	FreeVec(tags);
 	return a_ctx;
 }
+
+struct BitMap* amesa_get_bitmap(AMesaContext *a_ctx) {
+	if (a_ctx) {
+		return a_ctx->rast_port->BitMap;
+	}
+
+	return NULL;
+}
+
+GLboolean amesa_get_stage_times(AMesaContext *a_ctx, struct amesa_stage_times *times, GLboolean reset) {
+#ifdef AMESA_PROFILE
+	if (a_ctx) {
+		*times = a_ctx->stage_times;
+
+		if (reset) {
+			a_ctx->stage_times.tnl = 0.0;
+			a_ctx->stage_times.raster = 0.0;
+			a_ctx->stage_times.clear = 0.0;
+			a_ctx->stage_times.swap = 0.0;
+		}
+
+		return GL_TRUE;
+	}
+#endif
+
+	return GL_FALSE;
+}
+
+GLboolean amesa_get_frame_stats(AMesaContext *a_ctx, struct amesa_frame_stats *stats) {
+#ifdef AMESA_PROFILE
+	if (a_ctx) {
+		*stats = a_ctx->last_frame_stats;
+		return GL_TRUE;
+	}
+#endif
+
+	return GL_FALSE;
+}
@@ -35,12 +35,138 @@ extern "C" {
  */
 typedef struct amigamesa_context AMesaContext;
 
+/*
+ * Time spent in each stage of the pipeline, in seconds.  Only collected
+ * when the driver is built with AMESA_PROFILE.
+ */
+struct amesa_stage_times {
+	GLdouble tnl; /* Transform and lighting, excluding rasterization */
+	GLdouble raster; /* Primitive setup and rasterization */
+	GLdouble clear; /* Driver clear, including depth and stencil */
+	GLdouble swap; /* Presenting the back buffer */
+};
+
+/*
+ * The swrast device driver span and pixel hooks.
+ */
+enum amesa_span_hook {
+	AMESA_HOOK_WRITE_RGBA_SPAN,
+	AMESA_HOOK_WRITE_RGB_SPAN,
+	AMESA_HOOK_WRITE_MONO_RGBA_SPAN,
+	AMESA_HOOK_WRITE_RGBA_PIXELS,
+	AMESA_HOOK_WRITE_MONO_RGBA_PIXELS,
+	AMESA_HOOK_READ_RGBA_SPAN,
+	AMESA_HOOK_READ_RGBA_PIXELS,
+	AMESA_HOOK_COUNT
+};
+
+/*
+ * Counters for one frame.  Only collected when the driver is built with
+ * AMESA_PROFILE.
+ */
+struct amesa_frame_stats {
+	GLuint calls[AMESA_HOOK_COUNT]; /* Calls of each span/pixel hook */
+	GLuint pixels_written; /* Pixels that passed the mask */
+	GLuint masked_spans, unmasked_spans; /* Span writes with and without a mask */
+	GLuint full_clears, partial_clears; /* Colour buffer clears */
+	GLuint swap_bytes; /* Bytes presented by the swap */
+	GLuint triangles, triangles_culled; /* Triangles reaching swrast, and culled there */
+	GLuint lines, points; /* Lines and points reaching swrast */
+};
+
+/*
+ * Tags for amesa_create_context_tags().
+ */
+#define AMESA_Dummy        (TAG_USER + 0x414d00)
+#define AMESA_Window       (AMESA_Dummy + 1) /* (struct Window *) Window to render into */
+#define AMESA_Width        (AMESA_Dummy + 2) /* (GLuint) Offscreen width, when there is no window */
+#define AMESA_Height       (AMESA_Dummy + 3) /* (GLuint) Offscreen height */
+#define AMESA_PixelFormat  (AMESA_Dummy + 4) /* (GLuint) Offscreen PIXFMT_xxx, default PIXFMT_ARGB32 */
+#define AMESA_Buffers      (AMESA_Dummy + 5) /* (GLuint) 1 to copy a back buffer on swap (default), */
+                                             /* 2 or 3 to page flip the screen of the window */
+#define AMESA_DirectRender (AMESA_Dummy + 6) /* (GLboolean) See amesa_set_direct_render() */
+#define AMESA_RenderWidth  (AMESA_Dummy + 7) /* (GLuint) Render width, default the window width */
+#define AMESA_RenderHeight (AMESA_Dummy + 8) /* (GLuint) Render height, default the window height */
+#define AMESA_AsyncSwap    (AMESA_Dummy + 9) /* (GLboolean) Present frames from a separate task */
+#define AMESA_DepthFlip    (AMESA_Dummy + 10) /* (GLuint) AMESA_DEPTHFLIP_xxx, default NONE */
+#define AMESA_FixedPoint   (AMESA_Dummy + 11) /* (GLboolean) Rasterize in fixed point, default */
+                                              /* TRUE when the CPU has no FPU */
+#define AMESA_TexSubdivide (AMESA_Dummy + 12) /* (GLuint) Pixels between perspective divides when */
+                                              /* texturing, 8 or 16, default 0 for every pixel */
+
+/*
+ * Values of AMESA_DepthFlip.
+ */
+#define AMESA_DEPTHFLIP_NONE      0 /* Every depth clear is done */
+#define AMESA_DEPTHFLIP_ALTERNATE 1 /* Full depth clears are skipped every other frame */
+#define AMESA_DEPTHFLIP_NOCLEAR   2 /* Only the first full depth clear is done */
+
+#define AMESA_MAX_BUFFERS 3
 
 /*
  * Create the rendering context.
  */
 extern AMesaContext* amesa_create_context(struct Window *window);
 
+/*
+ * Create a rendering context that presents into a private bitmap of the
+ * given size and CyberGraphX pixel format (PIXFMT_xxx) instead of a window.
+ */
+extern AMesaContext* amesa_create_offscreen_context(GLuint width, GLuint height, GLuint format);
+
+/*
+ * Create a rendering context as described by the AMESA_xxx tags.
+ *
+ * With AMESA_Buffers set to 2 or 3 amesa_swap_buffers() flips between
+ * that many screen buffers (AllocScreenBuffer()) instead of copying the
+ * frame, and frames are drawn directly into them.  The window should be a
+ * borderless backdrop window covering its own screen, as Intuition does
+ * not redraw anything into the extra buffers.  With 3 buffers drawing the
+ * next frame does not have to wait for the last flip to complete.
+ *
+ * AMESA_RenderWidth/AMESA_RenderHeight render at a lower resolution than
+ * the window, e.g. half of it, which amesa_swap_buffers() scales up by
+ * pixel replication.  This cannot be combined with page flipping or
+ * direct rendering.
+ *
+ * AMESA_AsyncSwap renders into two back buffers in turn.  Swapping hands
+ * the finished one to a blitter task and returns straight away, so the
+ * next frame is drawn while the last one goes over the bus.  A swap or
+ * glFinish() only waits if the frame before is still being presented.
+ * The back buffer is undefined after a swap, so every frame has to be
+ * drawn in full.  This cannot be combined with page flipping or direct
+ * rendering.
+ *
+ * AMESA_DepthFlip puts every other frame in the upper half of the depth
+ * buffer with the depth range and comparisons reversed, so a frame always
+ * passes the depth test against the frame before and full depth clears
+ * can be skipped.  With AMESA_DEPTHFLIP_NOCLEAR every pixel has to be
+ * drawn every frame.  Skipped or not, depth clears go to the middle of
+ * the buffer and glClearDepth() is ignored; scenes should test with
+ * GL_LESS or GL_LEQUAL against cleared depth.  Depth precision is one bit
+ * less and polygon offset pushes the other way on odd frames.
+ *
+ * AMESA_FixedPoint makes the driver's triangles set up and interpolate
+ * color, depth and texture coordinates in integer arithmetic, so a CPU
+ * without an FPU does not trap into emulation for every span.  Colors
+ * are within a step of the floating-point triangles, depth within what
+ * moving the vertices by 1/256 pixel makes.  Textures are always
+ * subdivided, every 8 pixels unless AMESA_TexSubdivide asks for 16.
+ *
+ * AMESA_TexSubdivide makes the driver's textured triangles divide by q
+ * only every 8 or 16 pixels of a span and step the texel coordinates
+ * linearly in between, which is a lot faster and slightly off on steep
+ * polygons.  Without it this is done 16 pixels at a time while
+ * GL_PERSPECTIVE_CORRECTION_HINT is GL_FASTEST.
+ */
+extern AMesaContext* amesa_create_context_taglist(const struct TagItem *tags);
+
+/*
+ * Varargs version of amesa_create_context_taglist().  On 64-bit hosts
+ * the tag data is read as IPTR, so cast it to that.
+ */
+extern AMesaContext* amesa_create_context_tags(Tag tag1, ...);
+
 /*
  * Destroy a rendering context.
  */
@@ -57,6 +183,42 @@ extern void amesa_make_current(AMesaContext *a_ctx);
  */
 extern void amesa_swap_buffers(AMesaContext *a_ctx);
 
+/*
+ * Swaps only present the part of the back buffer that changed since the
+ * previous swap.  Call this when the window contents have been lost (e.g.
+ * on IDCMP_REFRESHWINDOW for a simple refresh window) so that the next swap
+ * presents everything.
+ */
+extern void amesa_damage_window(AMesaContext *a_ctx);
+
+/*
+ * Render straight into the bitmap the context presents into, instead of
+ * into a back buffer that amesa_swap_buffers() copies over.  The bitmap is
+ * locked from the first drawing of a frame until the swap (or glFlush), so
+ * keep frames short.  Layers are bypassed, so only use this for fullscreen
+ * or backdrop windows that nothing overlaps.  Needs a linear bitmap,
+ * returns GL_FALSE otherwise.
+ */
+extern GLboolean amesa_set_direct_render(AMesaContext *a_ctx, GLboolean enable);
+
+/*
+ * Return the bitmap the context presents into, i.e. the window bitmap or
+ * the offscreen surface.
+ */
+extern struct BitMap* amesa_get_bitmap(AMesaContext *a_ctx);
+
+/*
+ * Get the time accumulated in each stage since the last reset, and
+ * optionally reset it.  Returns GL_FALSE when built without AMESA_PROFILE.
+ */
+extern GLboolean amesa_get_stage_times(AMesaContext *a_ctx, struct amesa_stage_times *times, GLboolean reset);
+
+/*
+ * Get the counters of the last completed frame, i.e. everything up to and
+ * including the last swap.  Returns GL_FALSE when built without AMESA_PROFILE.
+ */
+extern GLboolean amesa_get_frame_stats(AMesaContext *a_ctx, struct amesa_frame_stats *stats);
+
 
 
 
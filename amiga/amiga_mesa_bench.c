@@ -0,0 +1,1042 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <GL/amiga_mesa.h>
+#include "amiga_mesa_def.h"
+#include "amiga_mesa_bench.h"
+#include "amiga_mesa_display.h"
+#include "amiga_mesa_fill.h"
+#include "amiga_mesa_simd.h"
+#include "amiga_mesa_timer.h"
+
+#include "glheader.h"
+#include "context.h"
+#include "macros.h"
+#include "swrast/swrast.h"
+
+enum {
+	BENCH_WRITE_RGBA_SPAN,
+	BENCH_WRITE_RGB_SPAN,
+	BENCH_WRITE_MONO_RGBA_SPAN,
+	BENCH_WRITE_RGBA_PIXELS,
+	BENCH_WRITE_MONO_RGBA_PIXELS,
+	BENCH_READ_RGBA_SPAN,
+	BENCH_READ_RGBA_PIXELS
+};
+
+static const char *bench_span_names[AMESA_BENCH_SPAN_FUNCS] = {
+	"write_rgba_span",
+	"write_rgb_span",
+	"write_mono_rgba_span",
+	"write_rgba_pixels",
+	"write_mono_rgba_pixels",
+	"read_rgba_span",
+	"read_rgba_pixels"
+};
+
+static const char *bench_mask_names[AMESA_BENCH_MASK_COUNT] = {
+	"unmasked",
+	"mask runs",
+	"mask random"
+};
+
+// Masks are read at a small varying offset so that consecutive spans
+// see different patterns.
+#define BENCH_MASK_SLACK 64
+
+/*
+ * Synthetic input shared by all the runs.
+ */
+struct bench_data {
+	GLchan (*rgba)[4];
+	GLchan (*rgb)[3];
+	GLubyte *mask[AMESA_BENCH_MASK_COUNT];
+	GLint *px, *py; /* Scattered coordinates for the pixel functions */
+	GLint *span_x; /* Start of the span of each length */
+};
+
+static GLuint bench_random(GLuint *seed) {
+	*seed = *seed * 1103515245 + 12345;
+	return (*seed >> 16) & 0x7fff;
+}
+
+static void bench_free_data(struct bench_data *d) {
+	GLuint i;
+
+	FreeVec(d->rgba);
+	FreeVec(d->rgb);
+	FreeVec(d->px);
+	FreeVec(d->py);
+	FreeVec(d->span_x);
+
+	for (i = 0; i < AMESA_BENCH_MASK_COUNT; i++) {
+		FreeVec(d->mask[i]);
+	}
+}
+
+static GLboolean bench_init_data(struct bench_data *d, GLuint width, GLuint height) {
+	GLuint mask_size = width + BENCH_MASK_SLACK;
+	GLuint seed = 1;
+	GLuint i, m;
+
+	d->rgba = AllocVec(width * sizeof(*d->rgba), MEMF_PUBLIC);
+	d->rgb = AllocVec(width * sizeof(*d->rgb), MEMF_PUBLIC);
+	d->px = AllocVec(width * sizeof(GLint), MEMF_PUBLIC);
+	d->py = AllocVec(width * sizeof(GLint), MEMF_PUBLIC);
+	d->span_x = AllocVec(width * sizeof(GLint), MEMF_PUBLIC);
+
+	for (m = 0; m < AMESA_BENCH_MASK_COUNT; m++) {
+		d->mask[m] = AllocVec(mask_size, MEMF_PUBLIC);
+	}
+
+	if (!d->rgba || !d->rgb || !d->px || !d->py || !d->span_x ||
+			!d->mask[AMESA_BENCH_UNMASKED] || !d->mask[AMESA_BENCH_MASK_RUNS] || !d->mask[AMESA_BENCH_MASK_RANDOM]) {
+		bench_free_data(d);
+		return GL_FALSE;
+	}
+
+	for (i = 0; i < width; i++) {
+		d->rgba[i][RCOMP] = d->rgb[i][RCOMP] = bench_random(&seed) & 0xff;
+		d->rgba[i][GCOMP] = d->rgb[i][GCOMP] = bench_random(&seed) & 0xff;
+		d->rgba[i][BCOMP] = d->rgb[i][BCOMP] = bench_random(&seed) & 0xff;
+		d->rgba[i][ACOMP] = bench_random(&seed) & 0xff;
+
+		d->px[i] = bench_random(&seed) % width;
+		d->py[i] = bench_random(&seed) % height;
+
+		// Spans of length i + 1 start anywhere they still fit.
+		d->span_x[i] = bench_random(&seed) % (width - i);
+	}
+
+	// The pixel functions always take a mask, "unmasked" means all set.
+	for (i = 0; i < mask_size; i++) {
+		d->mask[AMESA_BENCH_UNMASKED][i] = 1;
+		d->mask[AMESA_BENCH_MASK_RANDOM][i] = bench_random(&seed) & 1;
+	}
+
+	// Runs of 8 to 71 pixels, alternately visible and hidden.
+	for (i = 0, m = 1; i < mask_size; m ^= 1) {
+		GLuint run = 8 + (bench_random(&seed) & 63);
+
+		while (run-- && (i < mask_size)) {
+			d->mask[AMESA_BENCH_MASK_RUNS][i++] = m;
+		}
+	}
+
+	return GL_TRUE;
+}
+
+/*
+ * Whether the driver runs vector kernels, which are then measured against
+ * the scalar code as well.
+ */
+static GLboolean bench_simd(void) {
+#ifdef AMESA_SIMD
+	return amesa_simd.fill != NULL;
+#else
+	return GL_FALSE;
+#endif
+}
+
+/*
+ * Run one hook over spans of length 1..width until 'seconds' have passed,
+ * returns the throughput in Mpixels/s.
+ */
+static GLdouble bench_run(GLcontext *gl_ctx, struct swrast_device_driver *swdd, GLuint func,
+		const GLubyte *mask, struct bench_data *d, GLuint width, GLuint height, GLdouble seconds) {
+	const GLdouble pixels_per_pass = (GLdouble) width * (width + 1) / 2;
+	GLchan (*rgba)[4] = d->rgba;
+	GLdouble start, elapsed, pixels = 0.0;
+	GLuint n;
+
+	if (swdd->SpanRenderStart) {
+		swdd->SpanRenderStart(gl_ctx);
+	}
+
+	start = amesa_timer_now();
+
+	do {
+		for (n = 1; n <= width; n++) {
+			const GLubyte *m = mask ? mask + (n & (BENCH_MASK_SLACK - 1)) : NULL;
+			GLint x = d->span_x[n - 1];
+			GLint y = n % height;
+
+			switch (func) {
+			case BENCH_WRITE_RGBA_SPAN:
+				swdd->WriteRGBASpan(gl_ctx, n, x, y, (CONST GLchan (*)[4]) d->rgba, m);
+				break;
+			case BENCH_WRITE_RGB_SPAN:
+				swdd->WriteRGBSpan(gl_ctx, n, x, y, (CONST GLchan (*)[3]) d->rgb, m);
+				break;
+			case BENCH_WRITE_MONO_RGBA_SPAN:
+				swdd->WriteMonoRGBASpan(gl_ctx, n, x, y, d->rgba[n - 1], m);
+				break;
+			case BENCH_WRITE_RGBA_PIXELS:
+				swdd->WriteRGBAPixels(gl_ctx, n, d->px, d->py, (CONST GLchan (*)[4]) d->rgba, m);
+				break;
+			case BENCH_WRITE_MONO_RGBA_PIXELS:
+				swdd->WriteMonoRGBAPixels(gl_ctx, n, d->px, d->py, d->rgba[n - 1], m);
+				break;
+			case BENCH_READ_RGBA_SPAN:
+				swdd->ReadRGBASpan(gl_ctx, n, x, y, rgba);
+				break;
+			default: // BENCH_READ_RGBA_PIXELS
+				swdd->ReadRGBAPixels(gl_ctx, n, d->px, d->py, rgba, m);
+				break;
+			}
+		}
+
+		pixels += pixels_per_pass;
+		elapsed = amesa_timer_now() - start;
+	} while (elapsed < seconds);
+
+	if (swdd->SpanRenderFinish) {
+		swdd->SpanRenderFinish(gl_ctx);
+	}
+
+	return pixels / elapsed / 1000000.0;
+}
+
+GLboolean amesa_bench_spans(AMesaContext *a_ctx, GLdouble seconds,
+		struct amesa_span_bench results[AMESA_BENCH_SPAN_FUNCS]) {
+	GLcontext *gl_ctx = a_ctx->gl_ctx;
+	struct swrast_device_driver *swdd = _swrast_GetDeviceDriverReference(gl_ctx);
+	struct bench_data data = { 0 };
+	GLuint width = a_ctx->width;
+	GLuint height = a_ctx->height;
+	GLuint func, m;
+
+	if (!amesa_timer_open()) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Could not open the timer for benchmarking");
+		return GL_FALSE;
+	}
+
+	if (!bench_init_data(&data, width, height)) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the benchmark data");
+		amesa_timer_close();
+		return GL_FALSE;
+	}
+
+	for (func = 0; func < AMESA_BENCH_SPAN_FUNCS; func++) {
+		results[func].name = bench_span_names[func];
+
+		for (m = 0; m < AMESA_BENCH_MASK_COUNT; m++) {
+			const GLubyte *mask = data.mask[m];
+
+			results[func].scalar[m] = 0.0;
+
+			if ((func == BENCH_READ_RGBA_SPAN) && (m != AMESA_BENCH_UNMASKED)) {
+				// Span reads never take a mask.
+				results[func].mpixels[m] = 0.0;
+				continue;
+			}
+
+			if ((m == AMESA_BENCH_UNMASKED) && (func <= BENCH_WRITE_MONO_RGBA_SPAN || func == BENCH_READ_RGBA_SPAN)) {
+				// Spans have a dedicated unmasked path.
+				mask = NULL;
+			}
+
+			results[func].mpixels[m] = bench_run(gl_ctx, swdd, func, mask, &data, width, height, seconds);
+
+#ifdef AMESA_SIMD
+			if (bench_simd()) {
+				amesa_simd_init(GL_FALSE);
+				results[func].scalar[m] = bench_run(gl_ctx, swdd, func, mask, &data, width, height, seconds);
+				amesa_simd_init(GL_TRUE);
+			}
+#endif
+		}
+	}
+
+	bench_free_data(&data);
+	amesa_timer_close();
+	return GL_TRUE;
+}
+
+void amesa_bench_print_spans(FILE *out, const struct amesa_span_bench results[AMESA_BENCH_SPAN_FUNCS]) {
+	GLuint func, m;
+
+	fprintf(out, "%-24s", "Mpixels/s");
+	for (m = 0; m < AMESA_BENCH_MASK_COUNT; m++) {
+		fprintf(out, " %12s", bench_mask_names[m]);
+	}
+	fprintf(out, "\n");
+
+	for (func = 0; func < AMESA_BENCH_SPAN_FUNCS; func++) {
+		fprintf(out, "%-24s", results[func].name);
+		for (m = 0; m < AMESA_BENCH_MASK_COUNT; m++) {
+			if (results[func].mpixels[m] > 0.0) {
+				fprintf(out, " %12.2f", results[func].mpixels[m]);
+			} else {
+				fprintf(out, " %12s", "-");
+			}
+		}
+		fprintf(out, "\n");
+	}
+
+#ifdef AMESA_SIMD
+	if (results[0].scalar[AMESA_BENCH_UNMASKED] <= 0.0) {
+		return;
+	}
+
+	fprintf(out, "%-24s", amesa_simd.name);
+	for (m = 0; m < AMESA_BENCH_MASK_COUNT; m++) {
+		fprintf(out, " %12s", bench_mask_names[m]);
+	}
+	fprintf(out, "\n");
+
+	for (func = 0; func < AMESA_BENCH_SPAN_FUNCS; func++) {
+		fprintf(out, "%-24s", results[func].name);
+		for (m = 0; m < AMESA_BENCH_MASK_COUNT; m++) {
+			if (results[func].scalar[m] > 0.0) {
+				fprintf(out, " %11.2fx", results[func].mpixels[m] / results[func].scalar[m]);
+			} else {
+				fprintf(out, " %12s", "-");
+			}
+		}
+		fprintf(out, "\n");
+	}
+#endif
+}
+
+/*
+ * Fill a buffer over and over for about 'seconds', returns MB/s.
+ */
+static GLdouble bench_fill(GLubyte *buffer, GLuint size, GLdouble seconds) {
+	GLdouble start, elapsed, bytes = 0.0;
+	GLuint clr = 0x1a1a33ff;
+
+	// Change the color every time, so nothing can be skipped.
+	start = amesa_timer_now();
+	do {
+		amesa_fill(buffer, size, clr++);
+		bytes += size;
+		elapsed = amesa_timer_now() - start;
+	} while (elapsed < seconds);
+
+	return bytes / elapsed / 1000000.0;
+}
+
+GLboolean amesa_bench_clear(AMesaContext *a_ctx, GLdouble seconds, struct amesa_clear_bench *result) {
+	const GLuint size = a_ctx->height * a_ctx->pitch;
+	GLubyte *shadow, *buffer;
+	GLdouble start, elapsed, bytes;
+	GLuint clr = 0x1a1a33ff;
+
+	if (!amesa_timer_open()) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Could not open the timer for benchmarking");
+		return GL_FALSE;
+	}
+
+	shadow = AllocVec(size, MEMF_PUBLIC);
+	buffer = AllocVec(size, MEMF_PUBLIC);
+	if (!shadow || !buffer) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the benchmark buffers");
+		FreeVec(shadow);
+		FreeVec(buffer);
+		amesa_timer_close();
+		return GL_FALSE;
+	}
+
+	// The copy only pays for filling its source when the color changes.
+	amesa_fill(shadow, size, clr);
+
+	bytes = 0.0;
+	start = amesa_timer_now();
+	do {
+		CopyMemQuick(shadow, buffer, size);
+		bytes += size;
+		elapsed = amesa_timer_now() - start;
+	} while (elapsed < seconds);
+	result->copy_mbytes = bytes / elapsed / 1000000.0;
+
+	result->fill_mbytes = bench_fill(buffer, size, seconds);
+	result->scalar_fill_mbytes = 0.0;
+
+#ifdef AMESA_SIMD
+	if (bench_simd()) {
+		amesa_simd_init(GL_FALSE);
+		result->scalar_fill_mbytes = bench_fill(buffer, size, seconds);
+		amesa_simd_init(GL_TRUE);
+	}
+#endif
+
+	FreeVec(shadow);
+	FreeVec(buffer);
+	amesa_timer_close();
+	return GL_TRUE;
+}
+
+void amesa_bench_print_clear(FILE *out, const struct amesa_clear_bench *result) {
+	if (result->scalar_fill_mbytes > 0.0) {
+		fprintf(out, "%-24s %12s %12s %12s\n", "Clear MB/s", "copy", "fill", "scalar fill");
+		fprintf(out, "%-24s %12.2f %12.2f %12.2f\n", "back buffer", result->copy_mbytes, result->fill_mbytes,
+				result->scalar_fill_mbytes);
+	} else {
+		fprintf(out, "%-24s %12s %12s\n", "Clear MB/s", "copy", "fill");
+		fprintf(out, "%-24s %12.2f %12.2f\n", "back buffer", result->copy_mbytes, result->fill_mbytes);
+	}
+}
+
+/*
+ * Canonical scenes.  Each one sets up its own state inside a
+ * glPushAttrib()/glPopAttrib() pair and draws one frame per call.
+ */
+struct bench_scene_state {
+	GLuint width, height;
+	GLuint list; /* Display lists */
+	GLuint texture;
+	GLfloat *particles; /* x, y, z, r, g, b, a per particle */
+	GLubyte *image; /* Full-screen RGBA image for the blits */
+};
+
+struct bench_scene {
+	const char *name;
+	void (*setup)(struct bench_scene_state *state, GLuint width, GLuint height);
+	void (*draw)(struct bench_scene_state *state, GLuint frame);
+	void (*cleanup)(struct bench_scene_state *state);
+};
+
+#define BENCH_PI 3.14159265f
+
+#define BENCH_MESH_SIZE 48
+#define BENCH_PARTICLES 2000
+#define BENCH_TEXTURE_SIZE 64
+
+static void bench_perspective(GLuint width, GLuint height) {
+	GLdouble h = (GLdouble) height / (GLdouble) width;
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glFrustum(-1.0, 1.0, -h, h, 5.0, 60.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glTranslatef(0.0f, 0.0f, -40.0f);
+}
+
+/*
+ * Draw a gear wheel, as in the classic gears demo.
+ */
+static void bench_gear(GLfloat inner_radius, GLfloat outer_radius, GLfloat width, GLint teeth, GLfloat tooth_depth) {
+	GLfloat r0 = inner_radius;
+	GLfloat r1 = outer_radius - tooth_depth / 2.0f;
+	GLfloat r2 = outer_radius + tooth_depth / 2.0f;
+	GLfloat da = 2.0f * BENCH_PI / teeth / 4.0f;
+	GLfloat angle, u, v, len;
+	GLint i;
+
+	glShadeModel(GL_FLAT);
+	glNormal3f(0.0f, 0.0f, 1.0f);
+
+	// Front face.
+	glBegin(GL_QUAD_STRIP);
+	for (i = 0; i <= teeth; i++) {
+		angle = i * 2.0f * BENCH_PI / teeth;
+		glVertex3f(r0 * cos(angle), r0 * sin(angle), width * 0.5f);
+		glVertex3f(r1 * cos(angle), r1 * sin(angle), width * 0.5f);
+		if (i < teeth) {
+			glVertex3f(r0 * cos(angle), r0 * sin(angle), width * 0.5f);
+			glVertex3f(r1 * cos(angle + 3 * da), r1 * sin(angle + 3 * da), width * 0.5f);
+		}
+	}
+	glEnd();
+
+	// Front sides of the teeth.
+	glBegin(GL_QUADS);
+	for (i = 0; i < teeth; i++) {
+		angle = i * 2.0f * BENCH_PI / teeth;
+		glVertex3f(r1 * cos(angle), r1 * sin(angle), width * 0.5f);
+		glVertex3f(r2 * cos(angle + da), r2 * sin(angle + da), width * 0.5f);
+		glVertex3f(r2 * cos(angle + 2 * da), r2 * sin(angle + 2 * da), width * 0.5f);
+		glVertex3f(r1 * cos(angle + 3 * da), r1 * sin(angle + 3 * da), width * 0.5f);
+	}
+	glEnd();
+
+	glNormal3f(0.0f, 0.0f, -1.0f);
+
+	// Back face.
+	glBegin(GL_QUAD_STRIP);
+	for (i = 0; i <= teeth; i++) {
+		angle = i * 2.0f * BENCH_PI / teeth;
+		glVertex3f(r1 * cos(angle), r1 * sin(angle), -width * 0.5f);
+		glVertex3f(r0 * cos(angle), r0 * sin(angle), -width * 0.5f);
+		if (i < teeth) {
+			glVertex3f(r1 * cos(angle + 3 * da), r1 * sin(angle + 3 * da), -width * 0.5f);
+			glVertex3f(r0 * cos(angle), r0 * sin(angle), -width * 0.5f);
+		}
+	}
+	glEnd();
+
+	// Back sides of the teeth.
+	glBegin(GL_QUADS);
+	for (i = 0; i < teeth; i++) {
+		angle = i * 2.0f * BENCH_PI / teeth;
+		glVertex3f(r1 * cos(angle + 3 * da), r1 * sin(angle + 3 * da), -width * 0.5f);
+		glVertex3f(r2 * cos(angle + 2 * da), r2 * sin(angle + 2 * da), -width * 0.5f);
+		glVertex3f(r2 * cos(angle + da), r2 * sin(angle + da), -width * 0.5f);
+		glVertex3f(r1 * cos(angle), r1 * sin(angle), -width * 0.5f);
+	}
+	glEnd();
+
+	// Outward faces of the teeth.
+	glBegin(GL_QUAD_STRIP);
+	for (i = 0; i < teeth; i++) {
+		angle = i * 2.0f * BENCH_PI / teeth;
+
+		glVertex3f(r1 * cos(angle), r1 * sin(angle), width * 0.5f);
+		glVertex3f(r1 * cos(angle), r1 * sin(angle), -width * 0.5f);
+		u = r2 * cos(angle + da) - r1 * cos(angle);
+		v = r2 * sin(angle + da) - r1 * sin(angle);
+		len = sqrt(u * u + v * v);
+		glNormal3f(v / len, -u / len, 0.0f);
+		glVertex3f(r2 * cos(angle + da), r2 * sin(angle + da), width * 0.5f);
+		glVertex3f(r2 * cos(angle + da), r2 * sin(angle + da), -width * 0.5f);
+		glNormal3f(cos(angle), sin(angle), 0.0f);
+		glVertex3f(r2 * cos(angle + 2 * da), r2 * sin(angle + 2 * da), width * 0.5f);
+		glVertex3f(r2 * cos(angle + 2 * da), r2 * sin(angle + 2 * da), -width * 0.5f);
+		u = r1 * cos(angle + 3 * da) - r2 * cos(angle + 2 * da);
+		v = r1 * sin(angle + 3 * da) - r2 * sin(angle + 2 * da);
+		glNormal3f(v, -u, 0.0f);
+		glVertex3f(r1 * cos(angle + 3 * da), r1 * sin(angle + 3 * da), width * 0.5f);
+		glVertex3f(r1 * cos(angle + 3 * da), r1 * sin(angle + 3 * da), -width * 0.5f);
+		glNormal3f(cos(angle), sin(angle), 0.0f);
+	}
+	glVertex3f(r1, 0.0f, width * 0.5f);
+	glVertex3f(r1, 0.0f, -width * 0.5f);
+	glEnd();
+
+	// Inside radius cylinder.
+	glShadeModel(GL_SMOOTH);
+	glBegin(GL_QUAD_STRIP);
+	for (i = 0; i <= teeth; i++) {
+		angle = i * 2.0f * BENCH_PI / teeth;
+		glNormal3f(-cos(angle), -sin(angle), 0.0f);
+		glVertex3f(r0 * cos(angle), r0 * sin(angle), -width * 0.5f);
+		glVertex3f(r0 * cos(angle), r0 * sin(angle), width * 0.5f);
+	}
+	glEnd();
+}
+
+static void gears_setup(struct bench_scene_state *state, GLuint width, GLuint height) {
+	static const GLfloat pos[4] = { 5.0f, 5.0f, 10.0f, 0.0f };
+	static const GLfloat red[4] = { 0.8f, 0.1f, 0.0f, 1.0f };
+	static const GLfloat green[4] = { 0.0f, 0.8f, 0.2f, 1.0f };
+	static const GLfloat blue[4] = { 0.2f, 0.2f, 1.0f, 1.0f };
+
+	bench_perspective(width, height);
+
+	glLightfv(GL_LIGHT0, GL_POSITION, pos);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_NORMALIZE);
+
+	state->list = glGenLists(3);
+
+	glNewList(state->list, GL_COMPILE);
+	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, red);
+	bench_gear(1.0f, 4.0f, 1.0f, 20, 0.7f);
+	glEndList();
+
+	glNewList(state->list + 1, GL_COMPILE);
+	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, green);
+	bench_gear(0.5f, 2.0f, 2.0f, 10, 0.7f);
+	glEndList();
+
+	glNewList(state->list + 2, GL_COMPILE);
+	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, blue);
+	bench_gear(1.3f, 2.0f, 0.5f, 10, 0.7f);
+	glEndList();
+}
+
+static void gears_draw(struct bench_scene_state *state, GLuint frame) {
+	GLfloat angle = (GLfloat) frame * 2.0f;
+
+	glPushMatrix();
+	glRotatef(20.0f, 1.0f, 0.0f, 0.0f);
+	glRotatef(30.0f, 0.0f, 1.0f, 0.0f);
+
+	glPushMatrix();
+	glTranslatef(-3.0f, -2.0f, 0.0f);
+	glRotatef(angle, 0.0f, 0.0f, 1.0f);
+	glCallList(state->list);
+	glPopMatrix();
+
+	glPushMatrix();
+	glTranslatef(3.1f, -2.0f, 0.0f);
+	glRotatef(-2.0f * angle - 9.0f, 0.0f, 0.0f, 1.0f);
+	glCallList(state->list + 1);
+	glPopMatrix();
+
+	glPushMatrix();
+	glTranslatef(-3.1f, 4.2f, 0.0f);
+	glRotatef(-2.0f * angle - 25.0f, 0.0f, 0.0f, 1.0f);
+	glCallList(state->list + 2);
+	glPopMatrix();
+
+	glPopMatrix();
+}
+
+static void gears_cleanup(struct bench_scene_state *state) {
+	glDeleteLists(state->list, 3);
+}
+
+/*
+ * A rippling, vertex coloured grid.
+ */
+static void mesh_setup(struct bench_scene_state *state, GLuint width, GLuint height) {
+	bench_perspective(width, height);
+
+	glShadeModel(GL_SMOOTH);
+	glEnable(GL_DEPTH_TEST);
+}
+
+static void mesh_draw(struct bench_scene_state *state, GLuint frame) {
+	const GLfloat step = 24.0f / BENCH_MESH_SIZE;
+	const GLfloat phase = (GLfloat) frame * 0.1f;
+	GLint i, j;
+
+	glPushMatrix();
+	glRotatef(-60.0f, 1.0f, 0.0f, 0.0f);
+	glRotatef((GLfloat) frame, 0.0f, 0.0f, 1.0f);
+
+	for (j = 0; j < BENCH_MESH_SIZE; j++) {
+		glBegin(GL_TRIANGLE_STRIP);
+		for (i = 0; i <= BENCH_MESH_SIZE; i++) {
+			GLfloat x = -12.0f + i * step;
+			GLint k;
+
+			for (k = 0; k < 2; k++) {
+				GLfloat y = -12.0f + (j + k) * step;
+				GLfloat z = (GLfloat) sin(x * 0.5f + phase) * (GLfloat) cos(y * 0.5f + phase);
+
+				glColor3f(0.5f + 0.5f * z, (GLfloat) i / BENCH_MESH_SIZE, (GLfloat) (j + k) / BENCH_MESH_SIZE);
+				glVertex3f(x, y, z * 2.0f);
+			}
+		}
+		glEnd();
+	}
+
+	glPopMatrix();
+}
+
+static void mesh_cleanup(struct bench_scene_state *state) {
+}
+
+/*
+ * The inside of a box with checkerboard textured walls, floor and ceiling.
+ */
+static void room_setup(struct bench_scene_state *state, GLuint width, GLuint height) {
+	GLubyte *texels;
+	GLint i, j;
+
+	bench_perspective(width, height);
+	glLoadIdentity();
+
+	texels = AllocVec(BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 3, MEMF_PUBLIC);
+	if (texels) {
+		for (j = 0; j < BENCH_TEXTURE_SIZE; j++) {
+			for (i = 0; i < BENCH_TEXTURE_SIZE; i++) {
+				GLubyte *t = texels + (j * BENCH_TEXTURE_SIZE + i) * 3;
+				GLubyte c = (((i >> 3) ^ (j >> 3)) & 1) ? 200 : 60;
+
+				t[0] = c;
+				t[1] = c - (i & 31);
+				t[2] = c / 2 + (j & 31);
+			}
+		}
+	}
+
+	glGenTextures(1, &state->texture);
+	glBindTexture(GL_TEXTURE_2D, state->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	FreeVec(texels);
+
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glShadeModel(GL_SMOOTH);
+}
+
+static void room_quad(GLfloat x0, GLfloat y0, GLfloat z0, GLfloat x1, GLfloat y1, GLfloat z1,
+		GLfloat x2, GLfloat y2, GLfloat z2, GLfloat x3, GLfloat y3, GLfloat z3, GLfloat shade) {
+	glColor3f(shade, shade, shade);
+	glTexCoord2f(0.0f, 0.0f);
+	glVertex3f(x0, y0, z0);
+	glTexCoord2f(8.0f, 0.0f);
+	glVertex3f(x1, y1, z1);
+	glTexCoord2f(8.0f, 8.0f);
+	glVertex3f(x2, y2, z2);
+	glTexCoord2f(0.0f, 8.0f);
+	glVertex3f(x3, y3, z3);
+}
+
+static void room_draw(struct bench_scene_state *state, GLuint frame) {
+	const GLfloat s = 20.0f;
+
+	glPushMatrix();
+	glRotatef((GLfloat) frame * 0.5f, 0.0f, 1.0f, 0.0f);
+
+	glBegin(GL_QUADS);
+	room_quad(-s, -4, -s, s, -4, -s, s, -4, s, -s, -4, s, 0.6f); // floor
+	room_quad(-s, 8, s, s, 8, s, s, 8, -s, -s, 8, -s, 0.5f); // ceiling
+	room_quad(-s, -4, -s, -s, 8, -s, s, 8, -s, s, -4, -s, 1.0f); // walls
+	room_quad(s, -4, s, s, 8, s, -s, 8, s, -s, -4, s, 0.9f);
+	room_quad(-s, -4, s, -s, 8, s, -s, 8, -s, -s, -4, -s, 0.8f);
+	room_quad(s, -4, -s, s, 8, -s, s, 8, s, s, -4, s, 0.7f);
+	glEnd();
+
+	glPopMatrix();
+}
+
+static void room_cleanup(struct bench_scene_state *state) {
+	glDeleteTextures(1, &state->texture);
+}
+
+/*
+ * Alpha-blended points drifting over a dark background.
+ */
+static void particles_setup(struct bench_scene_state *state, GLuint width, GLuint height) {
+	GLuint seed = 7;
+	GLuint i;
+
+	bench_perspective(width, height);
+
+	state->particles = AllocVec(BENCH_PARTICLES * 7 * sizeof(GLfloat), MEMF_PUBLIC);
+	if (state->particles) {
+		for (i = 0; i < BENCH_PARTICLES; i++) {
+			GLfloat *p = state->particles + i * 7;
+
+			p[0] = (GLfloat) (bench_random(&seed) % 2000) / 100.0f - 10.0f;
+			p[1] = (GLfloat) (bench_random(&seed) % 2000) / 100.0f - 10.0f;
+			p[2] = (GLfloat) (bench_random(&seed) % 1000) / 100.0f - 5.0f;
+			p[3] = 1.0f;
+			p[4] = (GLfloat) (bench_random(&seed) & 255) / 255.0f;
+			p[5] = 0.2f;
+			p[6] = 0.5f;
+		}
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glPointSize(4.0f);
+}
+
+static void particles_draw(struct bench_scene_state *state, GLuint frame) {
+	const GLfloat rise = (GLfloat) (frame % 100) * 0.1f;
+	GLuint i;
+
+	if (!state->particles) {
+		return;
+	}
+
+	glBegin(GL_POINTS);
+	for (i = 0; i < BENCH_PARTICLES; i++) {
+		const GLfloat *p = state->particles + i * 7;
+
+		glColor4f(p[3], p[4], p[5], p[6]);
+		glVertex3f(p[0], p[1] + rise, p[2]);
+	}
+	glEnd();
+}
+
+static void particles_cleanup(struct bench_scene_state *state) {
+	FreeVec(state->particles);
+	state->particles = NULL;
+}
+
+/*
+ * Full-screen glDrawPixels, like a 2D game or video player would do.
+ */
+static void blit_setup(struct bench_scene_state *state, GLuint width, GLuint height) {
+	GLuint i, j;
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0, width, 0.0, height, -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_DITHER);
+
+	state->image = AllocVec(width * height * 4, MEMF_PUBLIC);
+	if (state->image) {
+		for (j = 0; j < height; j++) {
+			for (i = 0; i < width; i++) {
+				GLubyte *p = state->image + (j * width + i) * 4;
+
+				p[0] = i;
+				p[1] = j;
+				p[2] = i ^ j;
+				p[3] = 255;
+			}
+		}
+	}
+}
+
+static void blit_draw(struct bench_scene_state *state, GLuint frame) {
+	if (state->image) {
+		glRasterPos2i(0, 0);
+		glDrawPixels(state->width, state->height, GL_RGBA, GL_UNSIGNED_BYTE, state->image);
+	}
+}
+
+static void blit_cleanup(struct bench_scene_state *state) {
+	FreeVec(state->image);
+	state->image = NULL;
+}
+
+static const struct bench_scene bench_scenes[AMESA_BENCH_SCENES] = {
+	{ "gears", gears_setup, gears_draw, gears_cleanup },
+	{ "gouraud_mesh", mesh_setup, mesh_draw, mesh_cleanup },
+	{ "textured_room", room_setup, room_draw, room_cleanup },
+	{ "particles", particles_setup, particles_draw, particles_cleanup },
+	{ "blit_2d", blit_setup, blit_draw, blit_cleanup }
+};
+
+GLboolean amesa_bench_scenes(AMesaContext *a_ctx, GLuint frames,
+		struct amesa_scene_bench results[AMESA_BENCH_SCENES]) {
+	struct bench_scene_state state = { 0 };
+	struct amesa_stage_times times;
+	GLuint scene, frame;
+
+	if (!amesa_timer_open()) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Could not open the timer for benchmarking");
+		return GL_FALSE;
+	}
+
+	amesa_make_current(a_ctx);
+
+	state.width = a_ctx->width;
+	state.height = a_ctx->height;
+
+	for (scene = 0; scene < AMESA_BENCH_SCENES; scene++) {
+		const struct bench_scene *s = &bench_scenes[scene];
+		struct amesa_scene_bench *r = &results[scene];
+		GLdouble start;
+
+		glPushAttrib(GL_ALL_ATTRIB_BITS);
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+
+		glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
+		s->setup(&state, state.width, state.height);
+
+		// One untimed frame so display lists, textures and the swrast
+		// function choice are all settled.
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		s->draw(&state, 0);
+		amesa_swap_buffers(a_ctx);
+
+		amesa_get_stage_times(a_ctx, &times, GL_TRUE);
+		start = amesa_timer_now();
+
+		for (frame = 1; frame <= frames; frame++) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			s->draw(&state, frame);
+			amesa_swap_buffers(a_ctx);
+		}
+
+		r->name = s->name;
+		r->frames = frames;
+		r->seconds = amesa_timer_now() - start;
+		r->fps = (r->seconds > 0.0) ? frames / r->seconds : 0.0;
+		r->profiled = amesa_get_stage_times(a_ctx, &times, GL_TRUE);
+		amesa_get_frame_stats(a_ctx, &r->last_frame);
+
+		if (r->profiled && (frames > 0)) {
+			r->stages.tnl = times.tnl / frames;
+			r->stages.raster = times.raster / frames;
+			r->stages.clear = times.clear / frames;
+			r->stages.swap = times.swap / frames;
+			r->other = r->seconds / frames - (r->stages.tnl + r->stages.raster + r->stages.clear + r->stages.swap);
+		} else {
+			r->stages.tnl = r->stages.raster = r->stages.clear = r->stages.swap = 0.0;
+			r->other = 0.0;
+		}
+
+		s->cleanup(&state);
+
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+		glPopAttrib();
+	}
+
+	amesa_timer_close();
+	return GL_TRUE;
+}
+
+void amesa_bench_write_json(FILE *out, AMesaContext *a_ctx,
+		const struct amesa_scene_bench results[AMESA_BENCH_SCENES]) {
+	GLuint scene;
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"renderer\": \"%s\",\n", (const char*) glGetString(GL_RENDERER));
+	fprintf(out, "  \"width\": %u,\n", a_ctx->width);
+	fprintf(out, "  \"height\": %u,\n", a_ctx->height);
+	fprintf(out, "  \"pixfmt\": %u,\n", a_ctx->fmt);
+	fprintf(out, "  \"scenes\": [\n");
+
+	for (scene = 0; scene < AMESA_BENCH_SCENES; scene++) {
+		const struct amesa_scene_bench *r = &results[scene];
+
+		fprintf(out, "    {\n");
+		fprintf(out, "      \"name\": \"%s\",\n", r->name);
+		fprintf(out, "      \"frames\": %u,\n", r->frames);
+		fprintf(out, "      \"seconds\": %.6f,\n", r->seconds);
+		fprintf(out, "      \"fps\": %.3f,\n", r->fps);
+
+		if (r->profiled) {
+			// Stage times in milliseconds per frame.
+			fprintf(out, "      \"stages_ms\": {\n");
+			fprintf(out, "        \"tnl\": %.4f,\n", r->stages.tnl * 1000.0);
+			fprintf(out, "        \"raster\": %.4f,\n", r->stages.raster * 1000.0);
+			fprintf(out, "        \"clear\": %.4f,\n", r->stages.clear * 1000.0);
+			fprintf(out, "        \"swap\": %.4f,\n", r->stages.swap * 1000.0);
+			fprintf(out, "        \"other\": %.4f\n", r->other * 1000.0);
+			fprintf(out, "      },\n");
+			fprintf(out, "      \"last_frame\": {\n");
+			fprintf(out, "        \"pixels_written\": %u,\n", r->last_frame.pixels_written);
+			fprintf(out, "        \"masked_spans\": %u,\n", r->last_frame.masked_spans);
+			fprintf(out, "        \"unmasked_spans\": %u,\n", r->last_frame.unmasked_spans);
+			fprintf(out, "        \"full_clears\": %u,\n", r->last_frame.full_clears);
+			fprintf(out, "        \"partial_clears\": %u,\n", r->last_frame.partial_clears);
+			fprintf(out, "        \"swap_bytes\": %u,\n", r->last_frame.swap_bytes);
+			fprintf(out, "        \"triangles\": %u,\n", r->last_frame.triangles);
+			fprintf(out, "        \"triangles_culled\": %u,\n", r->last_frame.triangles_culled);
+			fprintf(out, "        \"lines\": %u,\n", r->last_frame.lines);
+			fprintf(out, "        \"points\": %u\n", r->last_frame.points);
+			fprintf(out, "      }\n");
+		} else {
+			fprintf(out, "      \"stages_ms\": null\n");
+		}
+
+		fprintf(out, "    }%s\n", (scene + 1 < AMESA_BENCH_SCENES) ? "," : "");
+	}
+
+	fprintf(out, "  ]\n");
+	fprintf(out, "}\n");
+}
+
+GLboolean amesa_bench_compare_fixed(AMesaContext *a_ctx, GLuint frame, GLuint tolerance,
+		GLuint max_differing, struct amesa_raster_compare results[AMESA_BENCH_SCENES]) {
+	const GLuint size = a_ctx->width * a_ctx->height * 4;
+	const GLboolean fixed_point = a_ctx->fixed_point;
+	struct bench_scene_state state = { 0 };
+	GLubyte *images[2];
+	GLuint scene, pass, i;
+
+	images[0] = AllocVec(size, MEMF_PUBLIC);
+	images[1] = AllocVec(size, MEMF_PUBLIC);
+	if (!images[0] || !images[1]) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the images to compare");
+		FreeVec(images[0]);
+		FreeVec(images[1]);
+		return GL_FALSE;
+	}
+
+	amesa_make_current(a_ctx);
+
+	state.width = a_ctx->width;
+	state.height = a_ctx->height;
+
+	for (scene = 0; scene < AMESA_BENCH_SCENES; scene++) {
+		const struct bench_scene *s = &bench_scenes[scene];
+		struct amesa_raster_compare *r = &results[scene];
+
+		glPushAttrib(GL_ALL_ATTRIB_BITS);
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+
+		glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
+		s->setup(&state, state.width, state.height);
+
+		for (pass = 0; pass < 2; pass++) {
+			amesa_display_set_fixed_point(a_ctx, (GLboolean) pass);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			s->draw(&state, frame);
+			glReadPixels(0, 0, state.width, state.height, GL_RGBA, GL_UNSIGNED_BYTE, images[pass]);
+		}
+
+		r->name = s->name;
+		r->pixels = state.width * state.height;
+		r->differing = 0;
+		r->allowed = (GLuint) (((unsigned long long) r->pixels * max_differing) / 1000);
+		r->max_error = 0;
+
+		for (i = 0; i < size; i += 4) {
+			GLuint error = 0;
+
+			for (GLuint c = 0; c < 4; c++) {
+				error = MAX2(error, (GLuint) ABSI(images[0][i + c] - images[1][i + c]));
+			}
+			r->max_error = MAX2(r->max_error, error);
+			r->differing += (error > tolerance);
+		}
+
+		s->cleanup(&state);
+
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+		glPopAttrib();
+	}
+
+	amesa_display_set_fixed_point(a_ctx, fixed_point);
+
+	FreeVec(images[0]);
+	FreeVec(images[1]);
+	return GL_TRUE;
+}
+
+GLboolean amesa_bench_print_compare(FILE *out, const struct amesa_raster_compare results[AMESA_BENCH_SCENES]) {
+	GLboolean pass = GL_TRUE;
+	GLuint scene;
+
+	fprintf(out, "%-24s %12s %12s %12s %12s\n", "Fixed vs float", "pixels", "differing", "allowed", "max error");
+	for (scene = 0; scene < AMESA_BENCH_SCENES; scene++) {
+		const struct amesa_raster_compare *r = &results[scene];
+
+		fprintf(out, "%-24s %12u %12u %12u %12u\n", r->name, r->pixels, r->differing, r->allowed, r->max_error);
+		pass &= (r->differing <= r->allowed);
+	}
+
+	return pass;
+}
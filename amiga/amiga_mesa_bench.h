@@ -0,0 +1,147 @@
+/* Amiga Mesa benchmarks */
+
+#ifndef AMIGA_MESA_BENCH_H
+#define AMIGA_MESA_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <GL/gl.h>
+#include <GL/amiga_mesa.h>
+
+/*
+ * Mask patterns the span functions are driven with.
+ */
+enum amesa_bench_mask {
+	AMESA_BENCH_UNMASKED,   /* No mask (spans) or an all-ones mask (pixels) */
+	AMESA_BENCH_MASK_RUNS,  /* Long runs of 0s and 1s, like depth tested geometry */
+	AMESA_BENCH_MASK_RANDOM, /* Every pixel randomly on or off */
+	AMESA_BENCH_MASK_COUNT
+};
+
+#define AMESA_BENCH_SPAN_FUNCS 7
+
+/*
+ * Throughput of one swrast device driver hook, in Mpixels/s for each mask
+ * pattern.  Patterns that do not apply to a hook are reported as 0.  When
+ * the driver uses vector kernels (see amiga_mesa_simd.h) the hooks are run
+ * again with them turned off, for 'scalar'.  It is all 0 otherwise.
+ */
+struct amesa_span_bench {
+	const char *name;
+	GLdouble mpixels[AMESA_BENCH_MASK_COUNT];
+	GLdouble scalar[AMESA_BENCH_MASK_COUNT];
+};
+
+/*
+ * Drive the span and pixel functions of the context directly with
+ * synthetic spans of every length from 1 to the window width, spending
+ * about 'seconds' on each hook and mask pattern.
+ */
+extern GLboolean amesa_bench_spans(AMesaContext *a_ctx, GLdouble seconds,
+		struct amesa_span_bench results[AMESA_BENCH_SPAN_FUNCS]);
+
+/*
+ * Print span benchmark results as a table, followed by the speedup of the
+ * vector kernels if they were measured.
+ */
+extern void amesa_bench_print_spans(FILE *out, const struct amesa_span_bench results[AMESA_BENCH_SPAN_FUNCS]);
+
+/*
+ * Throughput of clearing a buffer the size of the back buffer, in MB/s,
+ * by copying a pre-filled buffer over it (how clears used to work) and
+ * with the fill kernel that clears now.  'scalar_fill_mbytes' is the
+ * scalar fill when the driver fills with a vector kernel, 0 otherwise.
+ */
+struct amesa_clear_bench {
+	GLdouble copy_mbytes;
+	GLdouble fill_mbytes;
+	GLdouble scalar_fill_mbytes;
+};
+
+/*
+ * Time both ways of clearing for about 'seconds' each.
+ */
+extern GLboolean amesa_bench_clear(AMesaContext *a_ctx, GLdouble seconds, struct amesa_clear_bench *result);
+
+/*
+ * Print clear benchmark results.
+ */
+extern void amesa_bench_print_clear(FILE *out, const struct amesa_clear_bench *result);
+
+#define AMESA_BENCH_SCENES 5
+
+/*
+ * Result of rendering one canonical scene.  The stage times are per frame
+ * and, like the frame counters, only filled in when the driver is built
+ * with AMESA_PROFILE.  'other' is whatever is left of the frame (e.g.
+ * glDrawPixels).
+ */
+struct amesa_scene_bench {
+	const char *name;
+	GLuint frames;
+	GLdouble seconds;
+	GLdouble fps;
+	GLboolean profiled;
+	struct amesa_stage_times stages;
+	GLdouble other;
+	struct amesa_frame_stats last_frame; /* Counters of the final frame */
+};
+
+/*
+ * Render each canonical scene (flat-shaded gears, Gouraud mesh, textured
+ * room, blended particles and full-screen 2D blits) for 'frames' frames
+ * through the normal clear, draw and amesa_swap_buffers() path.
+ */
+extern GLboolean amesa_bench_scenes(AMesaContext *a_ctx, GLuint frames,
+		struct amesa_scene_bench results[AMESA_BENCH_SCENES]);
+
+/*
+ * Write scene benchmark results as JSON, so runs can be diffed.
+ */
+extern void amesa_bench_write_json(FILE *out, AMesaContext *a_ctx,
+		const struct amesa_scene_bench results[AMESA_BENCH_SCENES]);
+
+/*
+ * How far one canonical scene drawn with the fixed-point triangles is from
+ * the same frame drawn with the floating-point ones.
+ */
+struct amesa_raster_compare {
+	const char *name;
+	GLuint pixels; /* Pixels compared */
+	GLuint differing; /* Pixels with a component off by more than the tolerance */
+	GLuint allowed; /* Differing pixels the scene passes with */
+	GLuint max_error; /* Largest difference of any component */
+};
+
+/*
+ * Differing pixels per thousand a scene passes with by default.  The
+ * fixed-point triangles snap vertices to 1/256 pixel and swrast to 1/2048,
+ * so pixels on the edges of triangles can go to the other side.  1% leaves
+ * room for those, while wrong colors, depth or texture coordinates inside
+ * the triangles make whole areas differ.
+ */
+#define AMESA_COMPARE_MAX_DIFFERING 10
+
+/*
+ * Draw frame 'frame' of each canonical scene in floating point and in
+ * fixed point (AMESA_FixedPoint) and compare the two images.  Pixels
+ * differ when a component is off by more than 'tolerance', and a scene
+ * passes with up to 'max_differing' of them per thousand pixels.
+ */
+extern GLboolean amesa_bench_compare_fixed(AMesaContext *a_ctx, GLuint frame, GLuint tolerance,
+		GLuint max_differing, struct amesa_raster_compare results[AMESA_BENCH_SCENES]);
+
+/*
+ * Print image comparison results, FALSE if any scene had more differing
+ * pixels than it passes with.
+ */
+extern GLboolean amesa_bench_print_compare(FILE *out, const struct amesa_raster_compare results[AMESA_BENCH_SCENES]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Blend-and-write functions for one blend mode, which blend the incoming
+ * colors straight into the packed 32-bit pixels of the back buffer.  This
+ * file is included by amiga_mesa_display.c once per mode, with these
+ * defined:
+ *
+ *   NAME(func)     - name of func for this mode
+ *   BLEND(rgba, d) - blend the GLubyte rgba[4] source color into the
+ *                    packed destination pixel d
+ *
+ * They work for all 32-bit layouts, with the shifts of the context in rs,
+ * gs, bs and as.  swrast hands the fragments of primitives to the RGBA
+ * span and pixel functions, NAME(init_blend_funcs)() installs those over
+ * the plain ones while primitives are rendered.
+ */
+
+/* Blend a horizontal span of RGBA color pixels with a boolean mask. */
+static void NAME(write_rgba_span)(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
+		const GLubyte rgba[][4], const GLubyte mask[]) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	RASTER_SHIFTS(a_ctx);
+
+	DRAW_BEGIN(a_ctx);
+	GLuint *buffer = DRAW_ADDRESS(a_ctx, GLuint, x, y);
+
+	STATS_SPAN(a_ctx, AMESA_HOOK_WRITE_RGBA_SPAN, n, mask);
+	dirty_rect(a_ctx, x, a_ctx->height - y - 1, n, 1);
+	TILES_SPAN(a_ctx, x, a_ctx->height - y - 1, n);
+
+	if (mask) {
+		GLuint i = 0, end;
+
+		while ((end = mask_run(mask, n, &i))) {
+			for (; i < end; i++) {
+				buffer[i] = BLEND(rgba[i], buffer[i]);
+			}
+		}
+	} else {
+		for (GLuint i = 0; i < n; i++) {
+			buffer[i] = BLEND(rgba[i], buffer[i]);
+		}
+	}
+}
+
+/* Blend an array of RGBA pixels with a boolean mask. */
+static void NAME(write_rgba_pixels)(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[],
+		const GLubyte rgba[][4], const GLubyte mask[]) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	RASTER_SHIFTS(a_ctx);
+
+	DRAW_BEGIN(a_ctx);
+	int h = a_ctx->height - 1;
+
+	STATS_PIXELS(a_ctx, AMESA_HOOK_WRITE_RGBA_PIXELS, n, mask);
+	TILES_PIXELS(a_ctx, n, x, y, mask);
+
+	GLint xmin = a_ctx->width, xmax = -1, ymin = h, ymax = -1;
+
+	for (GLuint i = 0; i < n; i++) {
+		if (mask[i]) {
+			GLuint *pixel = DRAW_ADDRESS(a_ctx, GLuint, x[i], y[i]);
+
+			*pixel = BLEND(rgba[i], *pixel);
+
+			if (x[i] < xmin) xmin = x[i];
+			if (x[i] > xmax) xmax = x[i];
+			if (y[i] < ymin) ymin = y[i];
+			if (y[i] > ymax) ymax = y[i];
+		}
+	}
+
+	if (xmax >= xmin) {
+		dirty_rect(a_ctx, xmin, h - ymax, xmax - xmin + 1, ymax - ymin + 1);
+	}
+}
+
+static void NAME(init_blend_funcs)(struct swrast_device_driver *swdd) {
+	swdd->WriteRGBASpan = NAME(write_rgba_span);
+	swdd->WriteRGBAPixels = NAME(write_rgba_pixels);
+}
+
+#undef NAME
+#undef BLEND
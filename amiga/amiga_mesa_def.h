@@ -3,19 +3,101 @@
 #define AMIGA_MESA_DEF_H
 
 #include <GL/gl.h>
+#include <GL/amiga_mesa.h>
 #include "context.h"
+#include "swrast/s_context.h"
+
+/*
+ * Tiles of a back buffer that were cleared but not drawn into since.  Their
+ * pixels are only filled in when something touches them, and presenting
+ * fills them on the display instead.
+ */
+struct amesa_tiles {
+	GLubyte *cleared; /* Flag per tile, tiles_x * tiles_y of them */
+	GLuint count; /* Number of flags set */
+	GLuint color; /* Pixel the tiles were cleared to, replicated for 16-bit */
+	GLuint argb; /* The same color as ARGB, for FillPixelArray() */
+};
+
+/*
+ * A finished frame handed to the blitter task, and replied once it is on
+ * display.
+ */
+struct amesa_blit_msg {
+	struct Message msg;
+	GLubyte *buffer; /* Back buffer to present, NULL stops the task */
+	struct amesa_tiles *tiles; /* Its cleared tiles */
+	GLint x, row, width, height; /* Area of it that changed */
+};
 
 struct amigamesa_context {
 	GLcontext *gl_ctx; /* The core GL/Mesa context */
 	GLvisual *gl_visual; /* Describes the buffers */
 	GLframebuffer *gl_buffer; /* Depth, stencil, accum, etc buffers */
 	GLuint width, height; /* Drawable area */
+	GLuint display_width, display_height; /* Area presented, larger when scaling up */
 	GLuint pitch; /* Bytes per row */
+	GLuint pixel_bytes; /* Bytes per pixel, 2 or 4 */
 	GLuint fmt; /* Pixel format */
+	GLubyte shift[4]; /* Bit position of R, G, B and A in 32-bit pixels */
+	GLuint rect_fmt; /* RECTFMT_xxx of the back buffer, for presenting it */
 	GLuint clear_color; /* Color for clearing the pixel buffer */
-	GLubyte *clear_buffer; /* Pixel buffer */
+	GLuint clear_argb; /* The same color as ARGB */
 	GLubyte *back_buffer; /* Pixel buffer */
-	struct Window *hardware_window; /* Intuition window */
+	struct amesa_tiles *tiles; /* Cleared tiles of back_buffer */
+	struct amesa_tiles tile_maps[2]; /* For each back buffer */
+	GLuint tiles_x, tiles_y; /* Tiles per row and column */
+	GLint dirty_x1, dirty_y1; /* Area changed since the last swap, in back */
+	GLint dirty_x2, dirty_y2; /* buffer rows, x2/y2 exclusive, empty if x1 >= x2 */
+	struct Window *hardware_window; /* Intuition window, NULL when offscreen */
+	struct RastPort *rast_port; /* Where the back buffer gets presented */
+	GLuint dest_x, dest_y; /* Offset of the drawable area in rast_port */
+	struct BitMap *offscreen_bitmap; /* Offscreen surface, NULL when windowed */
+	struct RastPort offscreen_rport; /* Offscreen rast port */
+	GLboolean direct; /* Render straight into the bitmap of rast_port */
+	APTR direct_lock; /* LockBitMapTags() handle while the bitmap is locked */
+	GLubyte *draw_buffer; /* Where the span functions render, NULL until locked */
+	GLuint draw_pitch; /* Bytes per row of draw_buffer */
+	struct Screen *flip_screen; /* Screen being page flipped, NULL when not */
+	struct ScreenBuffer *screen_buffers[AMESA_MAX_BUFFERS];
+	GLuint buffers; /* Number of screen buffers flipped between */
+	GLuint draw_index, display_index; /* Screen buffer drawn into and on display */
+	GLboolean flip_drawn; /* The screen buffer at draw_index was drawn into directly */
+	GLuint flips_pending; /* Flips whose safe message has not arrived yet */
+	struct MsgPort *safe_port; /* Where the safe messages arrive */
+	struct RastPort flip_rport; /* For uploading into a screen buffer */
+	GLushort *scale_map; /* Back buffer column for each display column */
+	GLubyte *scale_strip; /* A few display rows to scale into */
+	GLuint scale_pitch; /* Bytes per row of scale_strip */
+	GLubyte *back_buffers[2]; /* Drawn into in turn when swapping asynchronously */
+	struct Task *blit_task; /* Presents the finished back buffer, NULL when not async */
+	struct MsgPort *blit_port; /* Where the blitter task takes frames */
+	struct MsgPort *blit_reply_port; /* Where it replies them */
+	struct amesa_blit_msg blit_msg;
+	GLboolean blit_pending; /* blit_msg has not been replied yet */
+	GLuint depth_flip; /* AMESA_DEPTHFLIP_xxx */
+	GLboolean depth_odd; /* Frame uses the reversed upper half of the depth buffer */
+	GLboolean depth_primed; /* The first full depth clear has been done */
+	GLenum depth_func; /* Depth function set by the application */
+	GLenum depth_test; /* Depth function the test runs with, reversed on odd frames */
+	GLuint z_xor, z_bias; /* Depth test of the driver rasterizers */
+	GLboolean fixed_point; /* Driver triangles rasterize in fixed point */
+	GLint cull_sign; /* Sign of the area of culled triangles, 0 for none */
+	GLuint tex_subdivide; /* AMESA_TexSubdivide */
+	GLuint subdiv_shift; /* Log2 of the pixels between perspective divides, 0 for every pixel */
+	GLuint blend; /* BLEND_xxx the span functions blend in place while rendering, 0 when swrast blends */
+	blend_func swrast_blend; /* swrast's blend function, put back after rendering */
+	void (*render_start)(GLcontext *gl_ctx); /* Wrapped tnl render hooks */
+	void (*render_finish)(GLcontext *gl_ctx);
+#ifdef AMESA_PROFILE
+	struct amesa_stage_times stage_times; /* Accumulated time per stage */
+	GLdouble raster_start; /* When the current render stage started */
+	struct amesa_frame_stats frame_stats; /* Counters of the frame being drawn */
+	struct amesa_frame_stats last_frame_stats; /* Counters of the last frame */
+	swrast_point_func point; /* Counted swrast primitive functions */
+	swrast_line_func line;
+	swrast_tri_func triangle;
+#endif
 };
 
 #endif
@@ -21,10 +21,16 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <GL/amiga_mesa.h>
 #include "amiga_mesa_def.h"
 #include "amiga_mesa_display.h"
+#include "amiga_mesa_fill.h"
+#include "amiga_mesa_raster.h"
+#include "amiga_mesa_simd.h"
+#include "amiga_mesa_swar.h"
+#include "amiga_mesa_timer.h"
 
 #include "glheader.h"
 #include "context.h"
@@ -32,13 +38,16 @@
 #include "dd.h"
 #include "depth.h"
 #include "extensions.h"
+#include "macros.h"
 #include "matrix.h"
+#include "math/m_matrix.h"
 #include "texformat.h"
 #include "teximage.h"
 #include "texstore.h"
 #include "array_cache/acache.h"
 #include "swrast/swrast.h"
 #include "swrast_setup/swrast_setup.h"
+#include "swrast/s_blend.h"
 #include "swrast/s_context.h"
 #include "swrast/s_depth.h"
 #include "swrast/s_lines.h"
@@ -48,15 +57,453 @@
 #include "tnl/t_context.h"
 #include "tnl/t_pipeline.h"
 
+#include <clib/alib_protos.h>
 #include <proto/cybergraphics.h>
 #include <cybergraphics/cybergraphics.h>
 
+// Display rows scaled at a time when rendering at a lower resolution.
+#define SCALE_STRIP_ROWS 16
+
+// Stack of the blitter task, it does little more than WritePixelArray().
+#define BLIT_STACK_SIZE 16384
+
+// A full clear is deferred in square tiles of this many pixels.
+#define TILE_SHIFT 5
+#define TILE_SIZE (1 << TILE_SHIFT)
+
 #define TC_ARGB32(r, g, b, a) (((a) << 24) | ((r) << 16) | ((g) << 8) | (b))
+#define TC_BGRA32(r, g, b, a) (((b) << 24) | ((g) << 16) | ((r) << 8) | (a))
+#define TC_RGBA32(r, g, b, a) (((r) << 24) | ((g) << 16) | ((b) << 8) | (a))
+
+#define UNPACK_ARGB32(p, rgba) do { \
+	(rgba)[RCOMP] = (GLubyte)((p) >> 16); \
+	(rgba)[GCOMP] = (GLubyte)((p) >> 8); \
+	(rgba)[BCOMP] = (GLubyte)(p); \
+	(rgba)[ACOMP] = (GLubyte)((p) >> 24); \
+} while (0)
+
+#define UNPACK_BGRA32(p, rgba) do { \
+	(rgba)[RCOMP] = (GLubyte)((p) >> 8); \
+	(rgba)[GCOMP] = (GLubyte)((p) >> 16); \
+	(rgba)[BCOMP] = (GLubyte)((p) >> 24); \
+	(rgba)[ACOMP] = (GLubyte)(p); \
+} while (0)
+
+#define UNPACK_RGBA32(p, rgba) do { \
+	(rgba)[RCOMP] = (GLubyte)((p) >> 24); \
+	(rgba)[GCOMP] = (GLubyte)((p) >> 16); \
+	(rgba)[BCOMP] = (GLubyte)((p) >> 8); \
+	(rgba)[ACOMP] = (GLubyte)(p); \
+} while (0)
+
+// 15/16-bit pixels, the PC formats are byte swapped.
+#define TC_RGB16(r, g, b) ((((r) & 0xf8) << 8) | (((g) & 0xfc) << 3) | ((b) >> 3))
+#define TC_RGB15(r, g, b) ((((r) & 0xf8) << 7) | (((g) & 0xf8) << 2) | ((b) >> 3))
+
+// Unpack with the high and low 5-bit fields going to components hi and lo.
+#define UNPACK_565(p, rgba, hi, lo) do { \
+	const GLuint h5 = ((p) >> 11) & 0x1f, g6 = ((p) >> 5) & 0x3f, l5 = (p) & 0x1f; \
+	(rgba)[hi] = (GLubyte)((h5 << 3) | (h5 >> 2)); \
+	(rgba)[GCOMP] = (GLubyte)((g6 << 2) | (g6 >> 4)); \
+	(rgba)[lo] = (GLubyte)((l5 << 3) | (l5 >> 2)); \
+	(rgba)[ACOMP] = 255; \
+} while (0)
+
+#define UNPACK_555(p, rgba, hi, lo) do { \
+	const GLuint h5 = ((p) >> 10) & 0x1f, g5 = ((p) >> 5) & 0x1f, l5 = (p) & 0x1f; \
+	(rgba)[hi] = (GLubyte)((h5 << 3) | (h5 >> 2)); \
+	(rgba)[GCOMP] = (GLubyte)((g5 << 3) | (g5 >> 2)); \
+	(rgba)[lo] = (GLubyte)((l5 << 3) | (l5 >> 2)); \
+	(rgba)[ACOMP] = 255; \
+} while (0)
+
+static inline GLushort swap16(GLuint p) {
+	return (GLushort) ((p >> 8) | (p << 8));
+}
+
+/*
+ * 4x4 ordered dither for the 15/16-bit formats.  Adds up to just under one
+ * step of the target precision before the low bits are dropped.
+ */
+static const GLubyte dither_4x4[4][4] = {
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+};
+
+#define DITHER_5(c, x, y) MIN2((c) + (dither_4x4[(y) & 3][(x) & 3] >> 1), 255)
+#define DITHER_6(c, x, y) MIN2((c) + (dither_4x4[(y) & 3][(x) & 3] >> 2), 255)
+
+#ifdef AMESA_PROFILE
+#define PROFILE_BEGIN() GLdouble profile_start = amesa_timer_now()
+#define PROFILE_END(a_ctx, stage) ((a_ctx)->stage_times.stage += amesa_timer_now() - profile_start)
+#else
+#define PROFILE_BEGIN()
+#define PROFILE_END(a_ctx, stage)
+#endif
+
+/*
+ * Make sure there is something to draw into.  In direct mode the bitmap is
+ * only locked once the frame actually touches it.
+ */
+#define DRAW_BEGIN(a_ctx) if (!(a_ctx)->draw_buffer) direct_lock(a_ctx)
+
+/*
+ * Address of the pixel at window position x, y in the draw buffer.  Window
+ * rows count up from the bottom, and the rows of a bitmap may be padded.
+ */
+#define DRAW_ADDRESS(a_ctx, type, x, y) \
+	((type*) ((a_ctx)->draw_buffer + (((a_ctx)->height - (y) - 1) * (a_ctx)->draw_pitch)) + (x))
+
+/*
+ * Fill in the cleared tiles under a span or pixels before they are drawn
+ * or read.  Tiles are only ever pending in the back buffer.
+ */
+#define TILES_SPAN(a_ctx, x, row, n) \
+	if ((a_ctx)->tiles->count) tiles_touch(a_ctx, (a_ctx)->tiles, (a_ctx)->back_buffer, x, row, n, 1)
+#define TILES_PIXELS(a_ctx, n, x, y, mask) \
+	if ((a_ctx)->tiles->count) tiles_touch_pixels(a_ctx, n, x, y, mask)
+
+#ifdef AMESA_PROFILE
+#define STATS_SPAN(a_ctx, hook, n, mask) stats_span(a_ctx, hook, n, mask)
+#define STATS_PIXELS(a_ctx, hook, n, mask) stats_pixels(a_ctx, hook, n, mask)
+#define STATS_READ(a_ctx, hook) ((a_ctx)->frame_stats.calls[hook]++)
+#define STATS_COUNT(a_ctx, counter, n) ((a_ctx)->frame_stats.counter += (n))
+#else
+#define STATS_SPAN(a_ctx, hook, n, mask)
+#define STATS_PIXELS(a_ctx, hook, n, mask)
+#define STATS_READ(a_ctx, hook)
+#define STATS_COUNT(a_ctx, counter, n)
+#endif
 
 static inline void WritePixelArrayEx(APTR a,UWORD b,UWORD c,UWORD d,struct RastPort *e, UWORD f,UWORD g,UWORD h,UWORD i,UBYTE j) {
 	WritePixelArray(a,b,c,d,e,f,g,h,i,j);
 }
 
+#ifdef AMESA_PROFILE
+static GLuint stats_mask_count(GLuint n, const GLubyte mask[]) {
+	GLuint count = 0;
+
+	for (GLuint i = 0; i < n; i++) {
+		count += (mask[i] != 0);
+	}
+
+	return count;
+}
+
+static void stats_span(AMesaContext *a_ctx, GLuint hook, GLuint n, const GLubyte mask[]) {
+	struct amesa_frame_stats *stats = &a_ctx->frame_stats;
+
+	stats->calls[hook]++;
+
+	if (mask) {
+		stats->masked_spans++;
+		stats->pixels_written += stats_mask_count(n, mask);
+	} else {
+		stats->unmasked_spans++;
+		stats->pixels_written += n;
+	}
+}
+
+static void stats_pixels(AMesaContext *a_ctx, GLuint hook, GLuint n, const GLubyte mask[]) {
+	a_ctx->frame_stats.calls[hook]++;
+	a_ctx->frame_stats.pixels_written += stats_mask_count(n, mask);
+}
+#endif
+
+/*
+ * Grow the dirty area to include the given rectangle (in back buffer rows).
+ */
+static inline void dirty_rect(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height) {
+	if (x < a_ctx->dirty_x1) {
+		a_ctx->dirty_x1 = x;
+	}
+	if (x + width > a_ctx->dirty_x2) {
+		a_ctx->dirty_x2 = x + width;
+	}
+	if (row < a_ctx->dirty_y1) {
+		a_ctx->dirty_y1 = row;
+	}
+	if (row + height > a_ctx->dirty_y2) {
+		a_ctx->dirty_y2 = row + height;
+	}
+}
+
+static inline void dirty_reset(AMesaContext *a_ctx) {
+	a_ctx->dirty_x1 = a_ctx->width;
+	a_ctx->dirty_y1 = a_ctx->height;
+	a_ctx->dirty_x2 = 0;
+	a_ctx->dirty_y2 = 0;
+}
+
+/*
+ * Fill a rectangle of a buffer with a pixel, 16-bit pixels replicated
+ * into both halves.
+ */
+static inline void fill_rect(AMesaContext *a_ctx, GLubyte *buffer, GLuint pitch,
+		GLint x, GLint row, GLint width, GLint height, GLuint clr) {
+	if ((width > 0) && (height > 0)) {
+		amesa_fill_rows(buffer + (row * pitch) + (x * a_ctx->pixel_bytes), pitch,
+				width * a_ctx->pixel_bytes, height, clr);
+	}
+}
+
+/*
+ * Flag every tile of the back buffer as cleared to the clear color.
+ */
+static void tiles_clear(AMesaContext *a_ctx) {
+	struct amesa_tiles *tiles = a_ctx->tiles;
+
+	tiles->count = a_ctx->tiles_x * a_ctx->tiles_y;
+	tiles->color = a_ctx->clear_color;
+	tiles->argb = a_ctx->clear_argb;
+	memset(tiles->cleared, 1, tiles->count);
+}
+
+/*
+ * Fill in the pixels of a cleared tile.
+ */
+static void tile_resolve(AMesaContext *a_ctx, struct amesa_tiles *tiles, GLubyte *buffer, GLint tx, GLint ty) {
+	const GLint x = tx << TILE_SHIFT;
+	const GLint row = ty << TILE_SHIFT;
+
+	fill_rect(a_ctx, buffer, a_ctx->pitch, x, row,
+			MIN2(TILE_SIZE, (GLint) a_ctx->width - x), MIN2(TILE_SIZE, (GLint) a_ctx->height - row), tiles->color);
+
+	tiles->cleared[(ty * a_ctx->tiles_x) + tx] = 0;
+	tiles->count--;
+}
+
+/*
+ * Fill in the cleared tiles that a rectangle of a back buffer overlaps.
+ */
+static void tiles_touch(AMesaContext *a_ctx, struct amesa_tiles *tiles, GLubyte *buffer,
+		GLint x, GLint row, GLint width, GLint height) {
+	if ((width <= 0) || (height <= 0)) {
+		return;
+	}
+
+	for (GLint ty = row >> TILE_SHIFT; ty <= (row + height - 1) >> TILE_SHIFT; ty++) {
+		const GLubyte *flags = tiles->cleared + (ty * a_ctx->tiles_x);
+
+		for (GLint tx = x >> TILE_SHIFT; tx <= (x + width - 1) >> TILE_SHIFT; tx++) {
+			if (flags[tx]) {
+				tile_resolve(a_ctx, tiles, buffer, tx, ty);
+			}
+		}
+	}
+}
+
+static void tiles_touch_pixels(AMesaContext *a_ctx, GLuint n, const GLint x[], const GLint y[], const GLubyte mask[]) {
+	struct amesa_tiles *tiles = a_ctx->tiles;
+	const GLint h = a_ctx->height - 1;
+
+	for (GLuint i = 0; (i < n) && tiles->count; i++) {
+		if (mask[i]) {
+			const GLint tx = x[i] >> TILE_SHIFT;
+			const GLint ty = (h - y[i]) >> TILE_SHIFT;
+
+			if (tiles->cleared[(ty * a_ctx->tiles_x) + tx]) {
+				tile_resolve(a_ctx, tiles, a_ctx->back_buffer, tx, ty);
+			}
+		}
+	}
+}
+
+/*
+ * Collect the safe messages of earlier flips, and wait until the screen
+ * buffer to be drawn next has gone off display.  That buffer was last
+ * shown buffers - 1 flips ago, so all but the latest buffers - 2 flips
+ * must have completed.
+ */
+static void flip_wait(AMesaContext *a_ctx) {
+	for (;;) {
+		while (GetMsg(a_ctx->safe_port)) {
+			a_ctx->flips_pending--;
+		}
+
+		if (a_ctx->flips_pending + 2 <= a_ctx->buffers) {
+			break;
+		}
+
+		WaitPort(a_ctx->safe_port);
+	}
+}
+
+/*
+ * Put the screen buffer that was just drawn on display.
+ */
+static void flip_show(AMesaContext *a_ctx) {
+	if (ChangeScreenBuffer(a_ctx->flip_screen, a_ctx->screen_buffers[a_ctx->draw_index])) {
+		a_ctx->flips_pending++;
+		a_ctx->display_index = a_ctx->draw_index;
+		a_ctx->draw_index = (a_ctx->draw_index + 1) % a_ctx->buffers;
+	}
+
+	// Otherwise Intuition is busy (e.g. with a menu), the frame is dropped
+	// and the next one is drawn into the same buffer.
+}
+
+/*
+ * Wait until the blitter task has presented the last frame handed to it.
+ */
+static void blit_wait(AMesaContext *a_ctx) {
+	if (a_ctx->blit_pending) {
+		WaitPort(a_ctx->blit_reply_port);
+		GetMsg(a_ctx->blit_reply_port);
+		a_ctx->blit_pending = GL_FALSE;
+	}
+}
+
+/*
+ * Lock the bitmap of the rast port and point the span functions straight at
+ * the drawable area in it.  The lock is held until the next swap or flush.
+ *
+ * This bypasses layers, so it is only meant for fullscreen or backdrop
+ * windows that nothing else can overlap.  If the bitmap cannot be locked
+ * the frame goes through the back buffer instead.
+ */
+static void direct_lock(AMesaContext *a_ctx) {
+	struct BitMap *bm = a_ctx->rast_port->BitMap;
+	APTR base = NULL;
+	ULONG bytes_per_row = 0;
+	GLuint x = a_ctx->dest_x;
+	GLuint y = a_ctx->dest_y;
+
+	if (a_ctx->flip_screen) {
+		flip_wait(a_ctx);
+		bm = a_ctx->screen_buffers[a_ctx->draw_index]->sb_BitMap;
+	}
+
+	a_ctx->direct_lock = LockBitMapTags(bm,
+			LBMI_BASEADDRESS, &base,
+			LBMI_BYTESPERROW, &bytes_per_row,
+			TAG_DONE);
+
+	if (a_ctx->direct_lock && base) {
+		// The window rast port draws into the screen bitmap.
+		if (a_ctx->hardware_window) {
+			x += a_ctx->hardware_window->LeftEdge;
+			y += a_ctx->hardware_window->TopEdge;
+		}
+
+		a_ctx->draw_buffer = (GLubyte*) base + (y * bytes_per_row) + (x * a_ctx->pixel_bytes);
+		a_ctx->draw_pitch = bytes_per_row;
+
+		// Kept until the buffer is shown, however often the lock is
+		// dropped in between.
+		if (a_ctx->flip_screen) {
+			a_ctx->flip_drawn = GL_TRUE;
+		}
+	} else {
+		if (a_ctx->direct_lock) {
+			UnLockBitMap(a_ctx->direct_lock);
+			a_ctx->direct_lock = NULL;
+		}
+
+		a_ctx->draw_buffer = a_ctx->back_buffer;
+		a_ctx->draw_pitch = a_ctx->pitch;
+
+		// The screen buffer is a few frames behind the back buffer, so
+		// it needs all of it.
+		if (a_ctx->flip_screen) {
+			dirty_rect(a_ctx, 0, 0, a_ctx->width, a_ctx->height);
+		}
+	}
+}
+
+/*
+ * Release the bitmap lock, the next frame locks it again.  Whatever was
+ * drawn while locked is already on display, except when page flipping,
+ * where the swap shows it.
+ */
+static void direct_unlock(AMesaContext *a_ctx) {
+	if (a_ctx->direct_lock) {
+		UnLockBitMap(a_ctx->direct_lock);
+		a_ctx->direct_lock = NULL;
+		if (!a_ctx->flip_screen) {
+			dirty_reset(a_ctx);
+		}
+	}
+
+	if (a_ctx->direct) {
+		a_ctx->draw_buffer = NULL;
+	}
+}
+
+/*
+ * For the driver rasterizers: make sure there is something to draw into and
+ * grow the dirty area over a rectangle (in back buffer rows).
+ */
+void amesa_display_draw_rect(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height) {
+	DRAW_BEGIN(a_ctx);
+
+	if ((width > 0) && (height > 0)) {
+		dirty_rect(a_ctx, x, row, width, height);
+	}
+}
+
+void amesa_display_touch_tiles(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height) {
+	tiles_touch(a_ctx, a_ctx->tiles, a_ctx->back_buffer, x, row, width, height);
+}
+
+/*
+ * Fill in the cleared tiles along a line.  A piece of it a tile long
+ * overlaps at most four tiles, so the line is done in such pieces rather
+ * than by its bounding box.
+ */
+void amesa_display_touch_line(AMesaContext *a_ctx, GLint x0, GLint row0, GLint x1, GLint row1) {
+	const GLint dx = x1 - x0;
+	const GLint dy = row1 - row0;
+	const GLint n = MAX2(ABSI(dx), ABSI(dy));
+	GLint xa = x0, ya = row0;
+
+	for (GLint i = TILE_SIZE; a_ctx->tiles->count; i += TILE_SIZE) {
+		const GLint k = MIN2(i, n);
+		const GLint xb = x0 + ((dx * k) / n);
+		const GLint yb = row0 + ((dy * k) / n);
+
+		tiles_touch(a_ctx, a_ctx->tiles, a_ctx->back_buffer, MIN2(xa, xb), MIN2(ya, yb),
+				ABSI(xb - xa) + 1, ABSI(yb - ya) + 1);
+
+		if (k == n) {
+			break;
+		}
+		xa = xb;
+		ya = yb;
+	}
+}
+
+/*
+ * Pack a color in the pixel layout of the back buffer.
+ */
+static GLuint pack_color(AMesaContext *a_ctx, GLubyte r, GLubyte g, GLubyte b, GLubyte a) {
+	switch (a_ctx->fmt) {
+	case PIXFMT_BGRA32:
+		return TC_BGRA32(r, g, b, a);
+	case PIXFMT_RGBA32:
+		return TC_RGBA32(r, g, b, a);
+	case PIXFMT_RGB16:
+		return TC_RGB16(r, g, b);
+	case PIXFMT_RGB16PC:
+		return swap16(TC_RGB16(r, g, b));
+	case PIXFMT_BGR16PC:
+		return swap16(TC_RGB16(b, g, r));
+	case PIXFMT_RGB15:
+		return TC_RGB15(r, g, b);
+	case PIXFMT_RGB15PC:
+		return swap16(TC_RGB15(r, g, b));
+	case PIXFMT_BGR15PC:
+		return swap16(TC_RGB15(b, g, r));
+	default:
+		return TC_ARGB32(r, g, b, a);
+	}
+}
+
+static void choose_span_funcs(AMesaContext *a_ctx);
+static GLuint get_blend_mode(AMesaContext *a_ctx);
+
 static const GLubyte* get_string(GLcontext *ctx, GLenum name) {
 	if (name == GL_RENDERER) {
 		return (GLubyte*) "Mesa Amiga";
@@ -66,12 +513,19 @@ static const GLubyte* get_string(GLcontext *ctx, GLenum name) {
 }
 
 void amesa_display_update_state(GLcontext *gl_ctx, GLuint new_state) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
 	// Propagate state change information to swrast and swrast_setup
-	// modules.  The Amiga driver has no internal GL-dependent state.
+	// modules.
 	_swrast_InvalidateState(gl_ctx, new_state);
 	_swsetup_InvalidateState(gl_ctx, new_state);
 	_ac_InvalidateState(gl_ctx, new_state);
 	_tnl_InvalidateState(gl_ctx, new_state);
+
+	// The blend mode of the span functions, installed while rendering.
+	if (new_state & _NEW_COLOR) {
+		a_ctx->blend = get_blend_mode(a_ctx);
+	}
 }
 
 static void get_buffer_size(GLframebuffer *buffer, GLuint *width, GLuint *height) {
@@ -93,13 +547,29 @@ static void enable(GLcontext *gl_ctx, GLenum pname, GLboolean enable) {
 #ifdef DEBUG
 	_mesa_debug(NULL, "enable()....\n");
 #endif
-	// Note - Nothing currently supported.
+	// Switch between the dithered and plain 15/16-bit span functions.
+	if (pname == GL_DITHER) {
+		choose_span_funcs((AMesaContext*) gl_ctx->DriverCtx);
+	}
 }
 
 static void flush(GLcontext *gl_ctx) {
 #ifdef DEBUG
 	_mesa_debug(NULL, "flush()....\n");
 #endif
+	// Everything drawn so far is already in the bitmap when rendering
+	// directly, just don't keep others waiting on the lock.
+	direct_unlock((AMesaContext*) gl_ctx->DriverCtx);
+}
+
+static void finish(GLcontext *gl_ctx) {
+#ifdef DEBUG
+	_mesa_debug(NULL, "finish()....\n");
+#endif
+	flush(gl_ctx);
+
+	// The last swapped frame has to be on display as well.
+	blit_wait((AMesaContext*) gl_ctx->DriverCtx);
 }
 
 /*
@@ -108,250 +578,762 @@ static void flush(GLcontext *gl_ctx) {
 static void clear_color(GLcontext *gl_ctx, const GLfloat color[4]) {
     AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
     GLubyte r, g, b, a;
-    GLuint oldClearColor = a_ctx->clear_color;
 
     CLAMPED_FLOAT_TO_UBYTE(r, color[RCOMP]);
     CLAMPED_FLOAT_TO_UBYTE(g, color[GCOMP]);
     CLAMPED_FLOAT_TO_UBYTE(b, color[BCOMP]);
     CLAMPED_FLOAT_TO_UBYTE(a, color[ACOMP]);
 
-    a_ctx->clear_color = TC_ARGB32(r, g, b, a);
+    a_ctx->clear_color = pack_color(a_ctx, r, g, b, a);
+    a_ctx->clear_argb = TC_ARGB32(r, g, b, a);
 
-	// We only do this if the clear color actually changes.
-	if (a_ctx->clear_color != oldClearColor) {
-		// Total pixels in a non-padded buffer is simply width * height
-		GLuint *buffer = (GLuint*) a_ctx->clear_buffer;
-		GLuint clr = a_ctx->clear_color;
-		GLint total_pixels = a_ctx->width * a_ctx->height;
+    // 16-bit pixels are kept twice, so the buffer can be filled by words.
+    if (a_ctx->pixel_bytes == 2) {
+        a_ctx->clear_color |= a_ctx->clear_color << 16;
+    }
+}
 
-		for (GLint i = 0; i < total_pixels; i++) {
-			buffer[i] = clr;
-		}
-	}
+/*
+ * The depth function that gives the same result with the depth values
+ * mirrored.
+ */
+static GLenum depth_func_reversed(GLenum func) {
+    switch (func) {
+    case GL_LESS:
+        return GL_GREATER;
+    case GL_LEQUAL:
+        return GL_GEQUAL;
+    case GL_GREATER:
+        return GL_LESS;
+    case GL_GEQUAL:
+        return GL_LEQUAL;
+    default:
+        return func;
+    }
 }
 
 /*
- * Clear the specified region of the color buffer using the clear color
- * or index as specified by one of the two functions above.
- *
- * This procedure clears either the front and/or the back COLOR buffers.
- * Only the "left" buffer is cleared since we are not stereo.
- * Clearing of the other non-color buffers is left to the swrast.
+ * Map the depth range of the viewport into the half of the depth buffer
+ * the frame uses: the lower half on even frames, the upper half mirrored
+ * with the comparisons reversed on odd frames.  A gap is left around the
+ * middle, where depth clears go, that float rounding can't close.  The
+ * reversed function is only for the depth tests, the application keeps
+ * seeing its own in Depth.Func.
  */
-static void clear(GLcontext *gl_ctx, GLbitfield mask, GLboolean all,
-                  GLint x, GLint y, GLint width, GLint height) {
-    AMesaContext* a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
-    const GLuint colorMask = *((GLuint *) &gl_ctx->Color.ColorMask);
+static void depth_flip_apply(AMesaContext *a_ctx) {
+    GLcontext *gl_ctx = a_ctx->gl_ctx;
+    GLfloat *m = gl_ctx->Viewport._WindowMap.m;
+    const GLfloat n = gl_ctx->Viewport.Near;
+    const GLfloat f = gl_ctx->Viewport.Far;
+    const GLuint gap = (gl_ctx->DepthMax >> 15) | 1;
+    const GLfloat span = (GLfloat) ((gl_ctx->DepthMax >> 1) - gap);
+
+    if (!a_ctx->depth_flip) {
+        // Back to what Mesa sets up
+        m[MAT_SZ] = gl_ctx->DepthMaxF * ((f - n) / 2.0F);
+        m[MAT_TZ] = gl_ctx->DepthMaxF * ((f - n) / 2.0F + n);
+        a_ctx->depth_test = a_ctx->depth_func;
+    } else if (!a_ctx->depth_odd) {
+        m[MAT_SZ] = span * ((f - n) / 2.0F);
+        m[MAT_TZ] = span * ((f - n) / 2.0F + n);
+        a_ctx->depth_test = a_ctx->depth_func;
+    } else {
+        m[MAT_SZ] = -span * ((f - n) / 2.0F);
+        m[MAT_TZ] = gl_ctx->DepthMaxF - span * ((f - n) / 2.0F + n);
+        a_ctx->depth_test = depth_func_reversed(a_ctx->depth_func);
+    }
 
-    // Only proceed if color masking is off (standard behavior)
-    if (colorMask == 0xffffffff) {
-        if (mask & DD_FRONT_LEFT_BIT) {
-            if (all) {
-                // Bulk copy the pre-filled clear_buffer into the back_buffer
-                // In 32-bit non-padded mode, pitch is exactly width * 4
-                CopyMemQuick(a_ctx->clear_buffer, a_ctx->back_buffer, (a_ctx->height * a_ctx->pitch));
-            } else {
-                // Use 32-bit pointers for ARGB pixels
-                GLuint* buffer = (GLuint*) a_ctx->back_buffer;
-
-                // NEW APPROACH: Stride in pixels is just the width
-                const GLint stride = a_ctx->width;
-                const GLint ymax   = a_ctx->height - 1;
-                const GLuint clr   = a_ctx->clear_color; // Now a 32-bit value
-
-                for (GLint row = 0; row < height; row++) {
-                    GLint py = ymax - (y + row);
-                    if ((unsigned)py < (unsigned)a_ctx->height) {
-                        // Offset into the 32-bit buffer
-                        GLuint* dst = buffer + (py * stride) + x;
-
-                        // Fill the row with 32-bit ARGB values
-                        for (GLint col = 0; col < width; col++) {
-                            dst[col] = clr;
-                        }
-                    }
-                }
-            }
+    gl_ctx->NewState |= _NEW_DEPTH | _NEW_VIEWPORT;
+}
 
-            mask &= ~DD_FRONT_LEFT_BIT;
+/*
+ * Whether a full depth clear can be skipped in this frame.
+ */
+static GLboolean depth_flip_skip_clear(AMesaContext *a_ctx) {
+    switch (a_ctx->depth_flip) {
+    case AMESA_DEPTHFLIP_ALTERNATE:
+        // The clear of the even frame before still separates them.
+        return a_ctx->depth_odd;
+    case AMESA_DEPTHFLIP_NOCLEAR:
+        if (a_ctx->depth_primed) {
+            return GL_TRUE;
         }
-    }
-
-    // Pass remaining buffers (like Depth/Stencil) to the software rasterizer
-    if (mask) {
-        _swrast_Clear(gl_ctx, mask, all, x, y, width, height);
+        a_ctx->depth_primed = GL_TRUE;
+        return GL_FALSE;
+    default:
+        return GL_FALSE;
     }
 }
 
-/* Write a horizontal span of RGB color pixels with a boolean mask. */
-static void write_rgb_span(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
-                           const GLubyte rgba[][3], const GLubyte mask[]) {
+/*
+ * Mesa has updated the window map or the depth function, redo the
+ * mapping on top.
+ */
+static void depth_func(GLcontext *gl_ctx, GLenum func) {
     AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
 
-    // Calculate the start of the row in the 32-bit buffer (4 bytes per pixel)
-    // Using simple width-based indexing for the non-padded approach
-    GLuint *buffer = (GLuint*)a_ctx->back_buffer + (a_ctx->height - y - 1) * a_ctx->width + x;
-
-    if (mask) {
-        for (GLuint i = 0; i < n; i++) {
-            if (mask[i]) {
-                // Convert 3-component RGB to 32-bit ARGB (Alpha set to 255/Opaque)
-                buffer[i] = TC_ARGB32(rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], 255);
-            }
-        }
-    } else {
-        // FAST PATH: No mask, direct 32-bit writes
-        for (GLuint i = 0; i < n; i++) {
-            buffer[i] = TC_ARGB32(rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], 255);
-        }
+    a_ctx->depth_func = func;
+    a_ctx->depth_test = func;
+    if (a_ctx->depth_flip) {
+        depth_flip_apply(a_ctx);
     }
 }
 
-/* Write a horizontal span of RGBA color pixels with a boolean mask. */
-static void write_rgba_span(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
-                           const GLubyte rgba[][4], const GLubyte mask[]) {
-	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
-
-	// Simple 32-bit pointer math: (row offset) + x
-	GLuint *buffer = (GLuint*)a_ctx->back_buffer + (a_ctx->height - y - 1) * a_ctx->width + x;
+/*
+ * swrast tests depth against Depth.Func, so it gets the function of the
+ * frame while it draws and the application's back once it is done.  GL
+ * calls cannot come in between.
+ */
+static void span_render_start(GLcontext *gl_ctx) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
 
-	if (mask) {
-		for (GLuint i = 0; i < n; i++) {
-			if (mask[i]) {
-				buffer[i] = TC_ARGB32(rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], rgba[i][ACOMP]);
-			}
-		}
-	} else {
-		for (GLuint i = 0; i < n; i++) {
-			buffer[i] = TC_ARGB32(rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], rgba[i][ACOMP]);
-		}
-	}
+    gl_ctx->Depth.Func = a_ctx->depth_test;
 }
 
-/*
- * Write a horizontal span of pixels with a boolean mask.  The current color
- * is used for all pixels.
- */
-static void write_mono_rgba_span(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
-                                const GLchan color[4], const GLubyte mask[]) {
+static void span_render_finish(GLcontext *gl_ctx) {
     AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
 
-    GLuint hicolor = TC_ARGB32(color[RCOMP], color[GCOMP], color[BCOMP], color[ACOMP]);
-	GLuint *buffer = (GLuint*)a_ctx->back_buffer + (a_ctx->height - y - 1) * a_ctx->width + x;
+    gl_ctx->Depth.Func = a_ctx->depth_func;
+}
 
-	if (mask) {
-		for (GLuint i = 0; i < n; i++) {
-			if (mask[i]) {
-				buffer[i] = hicolor;
-			}
-		}
-	} else {
-		// Fast path for unmasked mono spans
-		for (GLuint i = 0; i < n; i++) {
-			buffer[i] = hicolor;
-		}
-	}
+static void depth_range(GLcontext *gl_ctx, GLclampd near_val, GLclampd far_val) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+    if (a_ctx->depth_flip) {
+        depth_flip_apply(a_ctx);
+    }
 }
 
-/* Write an array of RGBA pixels with a boolean mask. */
-static void write_rgba_pixels(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[],
-                             const GLubyte rgba[][4], const GLubyte mask[]) {
+static void viewport(GLcontext *gl_ctx, GLint x, GLint y, GLsizei width, GLsizei height) {
     AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
-    GLuint *buffer = (GLuint*) a_ctx->back_buffer;
-    int h = a_ctx->height - 1;
-    int w = a_ctx->width;
-
-    for (GLuint i = 0; i < n; i++) {
-        if (mask[i]) {
-            // Straightforward 32-bit array indexing
-            buffer[(h - y[i]) * w + x[i]] = TC_ARGB32(rgba[i][0], rgba[i][1], rgba[i][2], rgba[i][3]);
-        }
+
+    if (a_ctx->depth_flip) {
+        depth_flip_apply(a_ctx);
     }
 }
 
 /*
- * Write an array of pixels with a boolean mask.  The current color
- * is used for all pixels.
+ * The depth and stencil buffers of the mask the driver can clear itself,
+ * those that exist and are not write masked.
  */
-static void write_mono_rgba_pixels(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[], const GLchan color[4],
-		const GLubyte mask[]) {
-	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+static GLbitfield clear_aux_mask(GLcontext *gl_ctx, GLbitfield mask) {
+    GLframebuffer *buffer = gl_ctx->DrawBuffer;
+    GLbitfield aux = 0;
 
-	// Use 32-bit pointers for ARGB [cite: 18, 22]
-	GLuint *buffer = (GLuint*) a_ctx->back_buffer;
+    if ((mask & DD_DEPTH_BIT) && gl_ctx->Visual.depthBits && buffer->DepthBuffer && gl_ctx->Depth.Mask) {
+        aux |= DD_DEPTH_BIT;
+    }
 
-	// Convert the single mono color to 32-bit ARGB [cite: 13, 22]
-	GLuint hicolor = TC_ARGB32(color[RCOMP], color[GCOMP], color[BCOMP], color[ACOMP]);
+    if ((mask & DD_STENCIL_BIT) && gl_ctx->Visual.stencilBits && buffer->Stencil &&
+            (gl_ctx->Stencil.WriteMask == STENCIL_MAX)) {
+        aux |= DD_STENCIL_BIT;
+    }
 
-	int h = a_ctx->height - 1;
+    return aux;
+}
 
-	// In the non-padded approach, stride is just the width
-	int stride = a_ctx->width;
+/*
+ * Clear an area of the depth and stencil buffers in 'aux', and of the
+ * color buffer when 'color' is set, a row of each at a time so every row
+ * is only walked once.  x and y are in window coordinates.
+ */
+static void clear_rows(AMesaContext *a_ctx, GLbitfield aux, GLboolean color,
+                       GLint x, GLint y, GLint width, GLint height) {
+    GLcontext *gl_ctx = a_ctx->gl_ctx;
+    GLframebuffer *buffer = gl_ctx->DrawBuffer;
+    GLubyte *color_row = NULL;
+    GLubyte *depth_row = NULL;
+    GLstencil *stencil_row = NULL;
+    GLuint depth_clear = 0, depth_bytes = 0, depth_pitch = 0;
+
+    if ((width <= 0) || (height <= 0)) {
+        return;
+    }
 
-	for (GLuint i = 0; i < n; i++) {
-		if (mask[i]) {
-			// Accessing 32-bit pixels using the simplified width stride [cite: 19, 24, 39]
-			buffer[(h - y[i]) * stride + x[i]] = hicolor;
-		}
-	}
-}
+    // The color buffer is stored top down, the others bottom up.
+    if (color) {
+        color_row = a_ctx->draw_buffer + ((a_ctx->height - y - 1) * a_ctx->draw_pitch) + (x * a_ctx->pixel_bytes);
+    }
 
-/* Read a horizontal span of color pixels. */
-static void read_rgba_span(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y, GLubyte rgba[][4]) {
-    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+    if (aux & DD_DEPTH_BIT) {
+        GLuint depth_size;
 
-    // Use GLuint* to ensure the CPU performs 32-bit fetches
-    GLuint *src = (GLuint*)a_ctx->back_buffer + (a_ctx->height - y - 1) * a_ctx->width + x;
+        if (a_ctx->depth_flip) {
+            // Between the depth ranges of even and odd frames
+            depth_clear = gl_ctx->DepthMax >> 1;
+        } else {
+            depth_clear = (GLuint) (gl_ctx->Depth.Clear * gl_ctx->DepthMax);
+        }
 
-    for (GLuint i = 0; i < n; i++) {
-        GLuint pixel = src[i]; // Fetch the whole pixel at once
+        if (gl_ctx->Visual.depthBits <= 16) {
+            depth_clear |= depth_clear << 16;
+            depth_size = sizeof(GLushort);
+        } else {
+            depth_size = sizeof(GLuint);
+        }
 
-        rgba[i][RCOMP] = (GLubyte)((pixel >> 16) & 0xff);
-        rgba[i][GCOMP] = (GLubyte)((pixel >> 8)  & 0xff);
-        rgba[i][BCOMP] = (GLubyte)(pixel & 0xff);
-        rgba[i][ACOMP] = (GLubyte)((pixel >> 24) & 0xff);
+        depth_pitch = buffer->Width * depth_size;
+        depth_bytes = width * depth_size;
+        depth_row = (GLubyte*) buffer->DepthBuffer + (y * depth_pitch) + (x * depth_size);
     }
-}
 
-/* Read an array of color pixels. */
-static void read_rgba_pixels(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[], GLubyte rgba[][4],
-        const GLubyte mask[]) {
-    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+    if (aux & DD_STENCIL_BIT) {
+        stencil_row = buffer->Stencil + (y * buffer->Width) + x;
+    }
 
-    // Use 32-bit pointers for the ARGB back buffer
-    GLuint *buffer = (GLuint*) a_ctx->back_buffer;
+    // A buffer on its own is filled as a whole, unpadded rows make one
+    // long run.
+    if (!color && !stencil_row) {
+        amesa_fill_rows(depth_row, depth_pitch, depth_bytes, height, depth_clear);
+        return;
+    }
 
-    int h = a_ctx->height - 1;
+    if (!aux) {
+        fill_rect(a_ctx, a_ctx->draw_buffer, a_ctx->draw_pitch,
+                x, a_ctx->height - (y + height), width, height, a_ctx->clear_color);
+        return;
+    }
 
-    // In the non-padded approach, stride in pixels is exactly the width
-    int stride = a_ctx->width;
+    for (GLint row = 0; row < height; row++) {
+        if (color_row) {
+            amesa_fill(color_row, width * a_ctx->pixel_bytes, a_ctx->clear_color);
+            color_row -= a_ctx->draw_pitch;
+        }
 
-    for (GLuint i = 0; i < n; i++) {
-        if (mask[i]) {
-            // Read the 32-bit ARGB pixel
-            GLuint color = buffer[(h - y[i]) * stride + x[i]];
+        if (depth_row) {
+            amesa_fill(depth_row, depth_bytes, depth_clear);
+            depth_row += depth_pitch;
+        }
 
-            // Unpack ARGB8888 components (Byte 0: Alpha, 1: Red, 2: Green, 3: Blue)
-            rgba[i][RCOMP] = (GLubyte)((color >> 16) & 0xff); // Red
-            rgba[i][GCOMP] = (GLubyte)((color >> 8)  & 0xff); // Green
-            rgba[i][BCOMP] = (GLubyte)(color & 0xff); // Blue
-            rgba[i][ACOMP] = (GLubyte)((color >> 24) & 0xff); // Alpha
+        if (stencil_row) {
+            memset(stencil_row, gl_ctx->Stencil.Clear, width * sizeof(GLstencil));
+            stencil_row += buffer->Width;
         }
     }
 }
 
-// Setup pointers and other driver state that is constant for the life of a context.
-static void amesa_display_init_pointers(GLcontext *gl_ctx) {
-	struct swrast_device_driver *swdd = _swrast_GetDeviceDriverReference(gl_ctx);
-	TNLcontext *tnl_ctx = TNL_CONTEXT(gl_ctx);
+/*
+ * Clear the specified region of the color buffer using the clear color
+ * or index as specified by one of the two functions above.
+ *
+ * This procedure clears either the front and/or the back COLOR buffers.
+ * Only the "left" buffer is cleared since we are not stereo.  Unmasked
+ * depth and stencil buffers are cleared in the same pass, anything else
+ * is left to the swrast.
+ */
+static void clear(GLcontext *gl_ctx, GLbitfield mask, GLboolean all,
+                  GLint x, GLint y, GLint width, GLint height) {
+    AMesaContext* a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+    const GLuint colorMask = *((GLuint *) &gl_ctx->Color.ColorMask);
+    GLbitfield aux = clear_aux_mask(gl_ctx, mask);
+    GLboolean color = GL_FALSE;
+    PROFILE_BEGIN();
+
+    // The depth values of the frame before are all behind this one.
+    if ((aux & DD_DEPTH_BIT) && all && depth_flip_skip_clear(a_ctx)) {
+        aux &= ~DD_DEPTH_BIT;
+        mask &= ~DD_DEPTH_BIT;
+    }
 
-	gl_ctx->Driver.GetString = get_string;
-	gl_ctx->Driver.UpdateState = amesa_display_update_state;
-	gl_ctx->Driver.GetBufferSize = get_buffer_size;
-	gl_ctx->Driver.Enable = enable;
+    // Only proceed if color masking is off (standard behavior)
+    if ((colorMask == 0xffffffff) && (mask & DD_FRONT_LEFT_BIT)) {
+        DRAW_BEGIN(a_ctx);
+
+        if (all) {
+            STATS_COUNT(a_ctx, full_clears, 1);
+
+            if (!a_ctx->direct) {
+                // Only flag the tiles, they are filled in when first
+                // touched or filled on the display when presented.
+                tiles_clear(a_ctx);
+            } else {
+                color = GL_TRUE;
+            }
+        } else {
+            STATS_COUNT(a_ctx, partial_clears, 1);
+
+            // Cleared tiles only partly covered keep the rest of the
+            // earlier clear.
+            if (a_ctx->tiles->count) {
+                tiles_touch(a_ctx, a_ctx->tiles, a_ctx->back_buffer, x, a_ctx->height - (y + height), width, height);
+            }
+
+            color = GL_TRUE;
+        }
+
+        dirty_rect(a_ctx, x, a_ctx->height - (y + height), width, height);
+        mask &= ~DD_FRONT_LEFT_BIT;
+    }
+
+    if (color || aux) {
+        clear_rows(a_ctx, aux, color, x, y, width, height);
+        mask &= ~aux;
+    }
+
+    // Pass remaining buffers (like Accum) to the software rasterizer
+    if (mask) {
+        _swrast_Clear(gl_ctx, mask, all, x, y, width, height);
+    }
+
+    PROFILE_END(a_ctx, clear);
+}
+
+// Nonzero when a longword of mask entries has a clear byte in it.
+#define MASK_HAS_ZERO(w) (((w) - 0x01010101) & ~(w) & 0x80808080)
+
+// Four mask entries as one longword, memcpy() keeps it a single load
+// without aliasing the GLubyte mask.
+static inline GLuint mask_word(const GLubyte mask[]) {
+	GLuint w;
+
+	memcpy(&w, mask, sizeof(w));
+	return w;
+}
+
+/*
+ * Find the next run of set entries in a span mask, starting at *start.
+ * *start is moved to the first set entry and the end of its run is
+ * returned, 0 when there is none left.  Depth, alpha and stencil masks are
+ * mostly long runs of 0s and 1s, so both are skipped a longword at a time.
+ */
+static inline GLuint mask_run(const GLubyte mask[], GLuint n, GLuint *start) {
+	GLuint i = *start;
+
+	// Clear entries, bytewise up to the first longword.  The longword loops
+	// are only entered aligned, as the 68000 cannot read them otherwise.
+	while ((i < n) && !mask[i] && (((unsigned long) &mask[i]) & 3)) {
+		i++;
+	}
+	while ((i + 4 <= n) && !mask[i] && !mask_word(&mask[i])) {
+		i += 4;
+	}
+	while ((i < n) && !mask[i]) {
+		i++;
+	}
+
+	if (i >= n) {
+		return 0;
+	}
+	*start = i++;
+
+	// And set ones
+	while ((i < n) && mask[i] && (((unsigned long) &mask[i]) & 3)) {
+		i++;
+	}
+	while ((i + 4 <= n) && mask[i] && !MASK_HAS_ZERO(mask_word(&mask[i]))) {
+		i += 4;
+	}
+	while ((i < n) && mask[i]) {
+		i++;
+	}
+
+	return i;
+}
+
+/*
+ * Span functions for each 32-bit layout.  The back buffer is kept in the
+ * layout of the screen, so the swap is a straight copy.
+ */
+#define NAME(func) func##_argb32
+#define PIXEL_TYPE GLuint
+#define PACK_PIXEL(x, y, r, g, b, a) TC_ARGB32(r, g, b, a)
+#define UNPACK_PIXEL(p, rgba) UNPACK_ARGB32(p, rgba)
+#define SIMD_PIXELS
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_bgra32
+#define PIXEL_TYPE GLuint
+#define PACK_PIXEL(x, y, r, g, b, a) TC_BGRA32(r, g, b, a)
+#define UNPACK_PIXEL(p, rgba) UNPACK_BGRA32(p, rgba)
+#define SIMD_PIXELS
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgba32
+#define PIXEL_TYPE GLuint
+#define PACK_PIXEL(x, y, r, g, b, a) TC_RGBA32(r, g, b, a)
+#define UNPACK_PIXEL(p, rgba) UNPACK_RGBA32(p, rgba)
+#define SIMD_PIXELS
+#include "amiga_mesa_spantmp.h"
+
+/*
+ * Span functions for the 15/16-bit formats, each with and without
+ * dithering.  The BGR formats pack blue into the high bits.
+ */
+#define NAME(func) func##_rgb16
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) TC_RGB16(r, g, b)
+#define UNPACK_PIXEL(p, rgba) UNPACK_565(p, rgba, RCOMP, BCOMP)
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb16_dither
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) TC_RGB16(DITHER_5(r, x, y), DITHER_6(g, x, y), DITHER_5(b, x, y))
+#define UNPACK_PIXEL(p, rgba) UNPACK_565(p, rgba, RCOMP, BCOMP)
+#define DITHER
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb16pc
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB16(r, g, b))
+#define UNPACK_PIXEL(p, rgba) UNPACK_565(swap16(p), rgba, RCOMP, BCOMP)
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb16pc_dither
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB16(DITHER_5(r, x, y), DITHER_6(g, x, y), DITHER_5(b, x, y)))
+#define UNPACK_PIXEL(p, rgba) UNPACK_565(swap16(p), rgba, RCOMP, BCOMP)
+#define DITHER
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_bgr16pc
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB16(b, g, r))
+#define UNPACK_PIXEL(p, rgba) UNPACK_565(swap16(p), rgba, BCOMP, RCOMP)
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_bgr16pc_dither
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB16(DITHER_5(b, x, y), DITHER_6(g, x, y), DITHER_5(r, x, y)))
+#define UNPACK_PIXEL(p, rgba) UNPACK_565(swap16(p), rgba, BCOMP, RCOMP)
+#define DITHER
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb15
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) TC_RGB15(r, g, b)
+#define UNPACK_PIXEL(p, rgba) UNPACK_555(p, rgba, RCOMP, BCOMP)
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb15_dither
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) TC_RGB15(DITHER_5(r, x, y), DITHER_5(g, x, y), DITHER_5(b, x, y))
+#define UNPACK_PIXEL(p, rgba) UNPACK_555(p, rgba, RCOMP, BCOMP)
+#define DITHER
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb15pc
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB15(r, g, b))
+#define UNPACK_PIXEL(p, rgba) UNPACK_555(swap16(p), rgba, RCOMP, BCOMP)
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_rgb15pc_dither
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB15(DITHER_5(r, x, y), DITHER_5(g, x, y), DITHER_5(b, x, y)))
+#define UNPACK_PIXEL(p, rgba) UNPACK_555(swap16(p), rgba, RCOMP, BCOMP)
+#define DITHER
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_bgr15pc
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB15(b, g, r))
+#define UNPACK_PIXEL(p, rgba) UNPACK_555(swap16(p), rgba, BCOMP, RCOMP)
+#include "amiga_mesa_spantmp.h"
+
+#define NAME(func) func##_bgr15pc_dither
+#define PIXEL_TYPE GLushort
+#define PACK_PIXEL(x, y, r, g, b, a) swap16(TC_RGB15(DITHER_5(b, x, y), DITHER_5(g, x, y), DITHER_5(r, x, y)))
+#define UNPACK_PIXEL(p, rgba) UNPACK_555(swap16(p), rgba, BCOMP, RCOMP)
+#define DITHER
+#include "amiga_mesa_spantmp.h"
+
+/*
+ * Blend-and-write functions for the common blend modes, which blend into
+ * the packed pixels instead of swrast blending unpacked copies of them.
+ * They are exact at 0 and 255 and within one step in between.  Modulating
+ * multiplies by a different factor per component, so it cannot use the
+ * SWAR helpers.
+ */
+enum {
+	BLEND_NONE,
+	BLEND_ALPHA, /* GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA */
+	BLEND_ADD, /* GL_ONE, GL_ONE */
+	BLEND_MODULATE /* GL_DST_COLOR, GL_ZERO */
+};
+
+#define BLEND_SOURCE(rgba) RASTER_PACK((rgba)[RCOMP], (rgba)[GCOMP], (rgba)[BCOMP], (rgba)[ACOMP])
+#define BLEND_PROD(rgba, d, c, shift) ((((GLuint) (rgba)[c] * ((((d) >> (shift)) & 0xff) + 1)) >> 8) << (shift))
+
+#define NAME(func) func##_alpha
+#define BLEND(rgba, d) swar_lerp(d, BLEND_SOURCE(rgba), (rgba)[ACOMP] + ((rgba)[ACOMP] >> 7))
+#include "amiga_mesa_blendtmp.h"
+
+#define NAME(func) func##_add
+#define BLEND(rgba, d) swar_add_sat(BLEND_SOURCE(rgba), d)
+#include "amiga_mesa_blendtmp.h"
+
+#define NAME(func) func##_modulate
+#define BLEND(rgba, d) (BLEND_PROD(rgba, d, RCOMP, rs) | BLEND_PROD(rgba, d, GCOMP, gs) | \
+		BLEND_PROD(rgba, d, BCOMP, bs) | BLEND_PROD(rgba, d, ACOMP, as))
+#include "amiga_mesa_blendtmp.h"
+
+/*
+ * Install the span functions for the pixel format of the back buffer.
+ */
+static void choose_span_funcs(AMesaContext *a_ctx) {
+	struct swrast_device_driver *swdd = _swrast_GetDeviceDriverReference(a_ctx->gl_ctx);
+	const GLboolean dither = a_ctx->gl_ctx->Color.DitherFlag;
+
+	switch (a_ctx->fmt) {
+	case PIXFMT_BGRA32:
+		init_span_funcs_bgra32(swdd);
+		break;
+	case PIXFMT_RGBA32:
+		init_span_funcs_rgba32(swdd);
+		break;
+	case PIXFMT_RGB16:
+		dither ? init_span_funcs_rgb16_dither(swdd) : init_span_funcs_rgb16(swdd);
+		break;
+	case PIXFMT_RGB16PC:
+		dither ? init_span_funcs_rgb16pc_dither(swdd) : init_span_funcs_rgb16pc(swdd);
+		break;
+	case PIXFMT_BGR16PC:
+		dither ? init_span_funcs_bgr16pc_dither(swdd) : init_span_funcs_bgr16pc(swdd);
+		break;
+	case PIXFMT_RGB15:
+		dither ? init_span_funcs_rgb15_dither(swdd) : init_span_funcs_rgb15(swdd);
+		break;
+	case PIXFMT_RGB15PC:
+		dither ? init_span_funcs_rgb15pc_dither(swdd) : init_span_funcs_rgb15pc(swdd);
+		break;
+	case PIXFMT_BGR15PC:
+		dither ? init_span_funcs_bgr15pc_dither(swdd) : init_span_funcs_bgr15pc(swdd);
+		break;
+	default:
+		init_span_funcs_argb32(swdd);
+		break;
+	}
+}
+
+/*
+ * The BLEND_xxx the span functions can do for the current state.  Color
+ * masking and logic ops would need the destination before blending.
+ */
+static GLuint get_blend_mode(AMesaContext *a_ctx) {
+	const struct gl_colorbuffer_attrib *color = &a_ctx->gl_ctx->Color;
+
+	if ((a_ctx->pixel_bytes != 4) || !color->BlendEnabled || color->ColorLogicOpEnabled ||
+			(color->BlendEquation != GL_FUNC_ADD_EXT) ||
+			(color->BlendSrcRGB != color->BlendSrcA) || (color->BlendDstRGB != color->BlendDstA) ||
+			!color->ColorMask[RCOMP] || !color->ColorMask[GCOMP] ||
+			!color->ColorMask[BCOMP] || !color->ColorMask[ACOMP]) {
+		return BLEND_NONE;
+	}
+
+	if ((color->BlendSrcRGB == GL_SRC_ALPHA) && (color->BlendDstRGB == GL_ONE_MINUS_SRC_ALPHA)) {
+		return BLEND_ALPHA;
+	} else if ((color->BlendSrcRGB == GL_ONE) && (color->BlendDstRGB == GL_ONE)) {
+		return BLEND_ADD;
+	} else if ((color->BlendSrcRGB == GL_DST_COLOR) && (color->BlendDstRGB == GL_ZERO)) {
+		return BLEND_MODULATE;
+	} else {
+		return BLEND_NONE;
+	}
+}
+
+/*
+ * swrast blend function and read hooks while the span functions blend.
+ * swrast reads the destination before it blends, which the span functions
+ * do themselves from the packed pixels, so nothing is read and the colors
+ * are written unchanged.
+ */
+static void blend_passthrough(GLcontext *gl_ctx, GLuint n, const GLubyte mask[], GLchan src[][4],
+		CONST GLchan dst[][4]) {
+	// src goes to the blending span functions as it is.
+}
+
+static void blend_read_rgba_span(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y, GLubyte rgba[][4]) {
+	// Never looked at by blend_passthrough().
+}
+
+static void blend_read_rgba_pixels(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[],
+		GLubyte rgba[][4], const GLubyte mask[]) {
+	// Never looked at by blend_passthrough().
+}
+
+/*
+ * Blend in the span functions while the tnl render stage rasterizes
+ * primitives, and in swrast otherwise.  Fragments only come from there,
+ * glDrawPixels() and the like, which swrast still blends correctly.  Other
+ * writes, like the result of glAccum(GL_RETURN), must not blend at all.
+ * Color masks and logic ops, the other fragment operations reading the
+ * destination, do not go with BLEND_xxx, so the reads can be skipped while
+ * rendering.  choose_span_funcs() puts the real ones back.
+ */
+static void blend_begin(AMesaContext *a_ctx) {
+	struct swrast_device_driver *swdd = _swrast_GetDeviceDriverReference(a_ctx->gl_ctx);
+	SWcontext *swrast = SWRAST_CONTEXT(a_ctx->gl_ctx);
+
+	switch (a_ctx->blend) {
+	case BLEND_ALPHA:
+		init_blend_funcs_alpha(swdd);
+		break;
+	case BLEND_ADD:
+		init_blend_funcs_add(swdd);
+		break;
+	case BLEND_MODULATE:
+		init_blend_funcs_modulate(swdd);
+		break;
+	default:
+		return;
+	}
+
+	swdd->ReadRGBASpan = blend_read_rgba_span;
+	swdd->ReadRGBAPixels = blend_read_rgba_pixels;
+	a_ctx->swrast_blend = swrast->BlendFunc;
+	swrast->BlendFunc = blend_passthrough;
+}
+
+static void blend_end(AMesaContext *a_ctx) {
+	if (a_ctx->swrast_blend) {
+		SWRAST_CONTEXT(a_ctx->gl_ctx)->BlendFunc = a_ctx->swrast_blend;
+		a_ctx->swrast_blend = NULL;
+		choose_span_funcs(a_ctx);
+	}
+}
+
+/*
+ * Wrappers around the render hooks installed by swsetup.
+ */
+static void render_start(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+#ifdef AMESA_PROFILE
+	a_ctx->raster_start = amesa_timer_now();
+#endif
+	a_ctx->render_start(gl_ctx);
+	blend_begin(a_ctx);
+}
+
+static void render_finish(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+	blend_end(a_ctx);
+	a_ctx->render_finish(gl_ctx);
+#ifdef AMESA_PROFILE
+	a_ctx->stage_times.raster += amesa_timer_now() - a_ctx->raster_start;
+#endif
+}
+
+#ifdef AMESA_PROFILE
+/*
+ * Profiling wrappers.  The pipeline time minus the time spent between the
+ * render stage start and finish hooks is accounted as TNL.
+ */
+static void run_pipeline(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	GLdouble raster = a_ctx->stage_times.raster;
+	PROFILE_BEGIN();
+
+	_tnl_run_pipeline(gl_ctx);
+
+	PROFILE_END(a_ctx, tnl);
+	a_ctx->stage_times.tnl -= a_ctx->stage_times.raster - raster;
+}
+
+/*
+ * Counting wrappers around whatever primitive functions swrast chose.
+ */
+static void count_point(GLcontext *gl_ctx, const SWvertex *v0) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+	a_ctx->frame_stats.points++;
+	a_ctx->point(gl_ctx, v0);
+}
+
+static void count_line(GLcontext *gl_ctx, const SWvertex *v0, const SWvertex *v1) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+	a_ctx->frame_stats.lines++;
+	a_ctx->line(gl_ctx, v0, v1);
+}
+
+static void count_triangle(GLcontext *gl_ctx, const SWvertex *v0, const SWvertex *v1, const SWvertex *v2) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+	a_ctx->frame_stats.triangles++;
+
+	if (gl_ctx->Polygon.CullFlag) {
+		// Same facing test as s_tritemp.h, on the unsorted vertices.
+		const GLfloat ex = v2->win[0] - v0->win[0];
+		const GLfloat ey = v2->win[1] - v0->win[1];
+		const GLfloat fx = v1->win[0] - v0->win[0];
+		const GLfloat fy = v1->win[1] - v0->win[1];
+		const GLfloat area = ex * fy - fx * ey;
+
+		if ((gl_ctx->Polygon.CullFaceMode == GL_FRONT_AND_BACK) ||
+				(area * SWRAST_CONTEXT(gl_ctx)->_backface_sign < 0.0F)) {
+			a_ctx->frame_stats.triangles_culled++;
+		}
+	}
+
+	a_ctx->triangle(gl_ctx, v0, v1, v2);
+}
+
+#endif
+
+/*
+ * swrast choose hooks, the driver rasterizers where the state allows.
+ */
+static void choose_point(GLcontext *gl_ctx) {
+#ifdef AMESA_PROFILE
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	SWcontext *swrast = SWRAST_CONTEXT(gl_ctx);
+#endif
+
+	amesa_choose_point(gl_ctx);
+
+#ifdef AMESA_PROFILE
+	a_ctx->point = swrast->Point;
+	swrast->Point = count_point;
+#endif
+}
+
+static void choose_line(GLcontext *gl_ctx) {
+#ifdef AMESA_PROFILE
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	SWcontext *swrast = SWRAST_CONTEXT(gl_ctx);
+#endif
+
+	amesa_choose_line(gl_ctx);
+
+#ifdef AMESA_PROFILE
+	a_ctx->line = swrast->Line;
+	swrast->Line = count_line;
+#endif
+}
+
+static void choose_triangle(GLcontext *gl_ctx) {
+#ifdef AMESA_PROFILE
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	SWcontext *swrast = SWRAST_CONTEXT(gl_ctx);
+#endif
+
+	amesa_choose_triangle(gl_ctx);
+
+#ifdef AMESA_PROFILE
+	a_ctx->triangle = swrast->Triangle;
+	swrast->Triangle = count_triangle;
+#endif
+}
+
+// Setup pointers and other driver state that is constant for the life of a context.
+static void amesa_display_init_pointers(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	struct swrast_device_driver *swdd = _swrast_GetDeviceDriverReference(gl_ctx);
+	TNLcontext *tnl_ctx = TNL_CONTEXT(gl_ctx);
+
+	gl_ctx->Driver.GetString = get_string;
+	gl_ctx->Driver.UpdateState = amesa_display_update_state;
+	gl_ctx->Driver.GetBufferSize = get_buffer_size;
+	gl_ctx->Driver.Enable = enable;
 	gl_ctx->Driver.Flush = flush;
+	gl_ctx->Driver.Finish = finish;
 	gl_ctx->Driver.ClearColor = clear_color;
 	gl_ctx->Driver.Clear = clear;
+	gl_ctx->Driver.DepthFunc = depth_func;
+	gl_ctx->Driver.DepthRange = depth_range;
+	gl_ctx->Driver.Viewport = viewport;
 
 	gl_ctx->Driver.ResizeBuffers = _swrast_alloc_buffers;
 	gl_ctx->Driver.Accum = _swrast_Accum;
@@ -389,48 +1371,739 @@ static void amesa_display_init_pointers(GLcontext *gl_ctx) {
 	gl_ctx->Driver.CopyConvolutionFilter2D = _swrast_CopyConvolutionFilter2D;
 
 	swdd->SetBuffer = set_buffer;
+	swdd->SpanRenderStart = span_render_start;
+	swdd->SpanRenderFinish = span_render_finish;
 
-	 /* Pixel/span writing functions: */
-	swdd->WriteRGBSpan = write_rgb_span;
-	swdd->WriteRGBASpan = write_rgba_span;
-	swdd->WriteRGBAPixels = write_rgba_pixels;
+#ifdef AMESA_SIMD
+	amesa_simd_init(GL_TRUE);
+#endif
 
-	swdd->WriteMonoRGBASpan = write_mono_rgba_span;
-	swdd->WriteMonoRGBAPixels = write_mono_rgba_pixels;
+	 /* Pixel/span writing functions: */
+	choose_span_funcs(a_ctx);
 
-	swdd->ReadRGBASpan = read_rgba_span;
-	swdd->ReadRGBAPixels = read_rgba_pixels;
+	// Driver rasterizers where the state allows.
+	SWRAST_CONTEXT(gl_ctx)->choose_triangle = choose_triangle;
+	SWRAST_CONTEXT(gl_ctx)->invalidate_triangle |= AMESA_NEW_TRIANGLE;
+	SWRAST_CONTEXT(gl_ctx)->choose_line = choose_line;
+	SWRAST_CONTEXT(gl_ctx)->invalidate_line |= AMESA_NEW_LINE;
+	SWRAST_CONTEXT(gl_ctx)->choose_point = choose_point;
+	SWRAST_CONTEXT(gl_ctx)->invalidate_point |= AMESA_NEW_POINT;
 
 	// Initialize the TNL driver interface...
+#ifdef AMESA_PROFILE
+	tnl_ctx->Driver.RunPipeline = run_pipeline;
+#else
 	tnl_ctx->Driver.RunPipeline = _tnl_run_pipeline;
+#endif
+}
+
+/*
+ * Scale one back buffer row into a display row, starting at display
+ * column dx.  Exact doubling replicates each pixel, anything else picks
+ * the nearest pixel through the column map.
+ */
+static void scale_row(AMesaContext *a_ctx, const GLubyte *buffer, GLint sy, GLubyte *dst, GLint dx, GLint count) {
+	const GLubyte *src = buffer + (sy * a_ctx->pitch);
+	const GLushort *map = a_ctx->scale_map + dx;
+
+	if (a_ctx->display_width == 2 * a_ctx->width) {
+		if (a_ctx->pixel_bytes == 2) {
+			const GLushort *s = (const GLushort*) src + (dx >> 1);
+			GLushort *d = (GLushort*) dst;
+
+			if (dx & 1) {
+				*d++ = *s++;
+				count--;
+			}
+			for (; count >= 2; count -= 2) {
+				const GLushort p = *s++;
+				d[0] = p;
+				d[1] = p;
+				d += 2;
+			}
+			if (count) {
+				*d = *s;
+			}
+		} else {
+			const GLuint *s = (const GLuint*) src + (dx >> 1);
+			GLuint *d = (GLuint*) dst;
+
+			if (dx & 1) {
+				*d++ = *s++;
+				count--;
+			}
+			for (; count >= 2; count -= 2) {
+				const GLuint p = *s++;
+				d[0] = p;
+				d[1] = p;
+				d += 2;
+			}
+			if (count) {
+				*d = *s;
+			}
+		}
+	} else if (a_ctx->pixel_bytes == 2) {
+		const GLushort *s = (const GLushort*) src;
+		GLushort *d = (GLushort*) dst;
+
+		for (GLint i = 0; i < count; i++) {
+			d[i] = s[map[i]];
+		}
+	} else {
+		const GLuint *s = (const GLuint*) src;
+		GLuint *d = (GLuint*) dst;
+
+		for (GLint i = 0; i < count; i++) {
+			d[i] = s[map[i]];
+		}
+	}
+}
+
+/*
+ * The display area covering a back buffer rectangle, x2/y2 exclusive.
+ */
+static inline void scale_rect(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height,
+		GLint *dx1, GLint *dy1, GLint *dx2, GLint *dy2) {
+	*dx1 = (x * a_ctx->display_width) / a_ctx->width;
+	*dx2 = ((x + width) * a_ctx->display_width + a_ctx->width - 1) / a_ctx->width;
+	*dy1 = (row * a_ctx->display_height) / a_ctx->height;
+	*dy2 = ((row + height) * a_ctx->display_height + a_ctx->height - 1) / a_ctx->height;
+}
+
+/*
+ * Present a rectangle of a back buffer scaled up to the display size, a
+ * strip of display rows at a time.  Display rows that come from the same
+ * back buffer row are copied instead of scaled again.
+ */
+static void scale_present(AMesaContext *a_ctx, const GLubyte *buffer, struct RastPort *rast_port,
+		GLint x, GLint row, GLint width, GLint height) {
+	GLint dx1, dy1, dx2, dy2;
+	GLint row_bytes;
+
+	scale_rect(a_ctx, x, row, width, height, &dx1, &dy1, &dx2, &dy2);
+	row_bytes = (dx2 - dx1) * a_ctx->pixel_bytes;
+
+	for (GLint strip = dy1; strip < dy2; strip += SCALE_STRIP_ROWS) {
+		const GLint rows = MIN2(SCALE_STRIP_ROWS, dy2 - strip);
+		GLint last_sy = -1;
+
+		for (GLint i = 0; i < rows; i++) {
+			const GLint sy = ((strip + i) * a_ctx->height) / a_ctx->display_height;
+			GLubyte *dst = a_ctx->scale_strip + (i * a_ctx->scale_pitch);
+
+			if (sy == last_sy) {
+				CopyMem(dst - a_ctx->scale_pitch, dst, row_bytes);
+			} else {
+				scale_row(a_ctx, buffer, sy, dst, dx1, dx2 - dx1);
+			}
+			last_sy = sy;
+		}
+
+		WritePixelArrayEx(a_ctx->scale_strip, 0, 0, a_ctx->scale_pitch, rast_port,
+				a_ctx->dest_x + dx1, a_ctx->dest_y + strip, dx2 - dx1, rows, a_ctx->rect_fmt);
+	}
+}
+
+/*
+ * Present a rectangle of a back buffer that has cleared tiles, a row of
+ * tiles at a time.  Runs of cleared tiles are filled on the display and
+ * never go through memory, the rest is copied.
+ */
+static void present_tiles(AMesaContext *a_ctx, const GLubyte *buffer, const struct amesa_tiles *tiles,
+		struct RastPort *rast_port, GLint x, GLint row, GLint width, GLint height) {
+	const GLint x2 = x + width;
+	const GLint y2 = row + height;
+
+	for (GLint ty = row >> TILE_SHIFT; (ty << TILE_SHIFT) < y2; ty++) {
+		const GLubyte *flags = tiles->cleared + (ty * a_ctx->tiles_x);
+		const GLint y1 = MAX2(row, ty << TILE_SHIFT);
+		const GLint rows = MIN2(y2, (ty + 1) << TILE_SHIFT) - y1;
+		GLint tx = x >> TILE_SHIFT;
+		GLint run_x = x;
+
+		while (run_x < x2) {
+			const GLubyte cleared = flags[tx];
+			GLint run_end;
+
+			do {
+				tx++;
+			} while (((tx << TILE_SHIFT) < x2) && (flags[tx] == cleared));
+			run_end = MIN2(x2, tx << TILE_SHIFT);
+
+			if (cleared) {
+				FillPixelArray(rast_port, a_ctx->dest_x + run_x, a_ctx->dest_y + y1,
+						run_end - run_x, rows, tiles->argb);
+			} else {
+				WritePixelArrayEx((UBYTE*)buffer, run_x, y1, a_ctx->pitch, rast_port,
+						a_ctx->dest_x + run_x, a_ctx->dest_y + y1, run_end - run_x, rows, a_ctx->rect_fmt);
+			}
+
+			run_x = run_end;
+		}
+	}
+}
+
+/*
+ * Present a rectangle of a back buffer into the rast port.
+ */
+static void present_rect(AMesaContext *a_ctx, GLubyte *buffer, struct amesa_tiles *tiles,
+		struct RastPort *rast_port, GLint x, GLint row, GLint width, GLint height) {
+	if (a_ctx->scale_strip) {
+		// Scaling reads every pixel, so cleared tiles have to be filled in.
+		if (tiles->count) {
+			tiles_touch(a_ctx, tiles, buffer, x, row, width, height);
+		}
+
+		scale_present(a_ctx, buffer, rast_port, x, row, width, height);
+	} else if (tiles->count) {
+		present_tiles(a_ctx, buffer, tiles, rast_port, x, row, width, height);
+	} else {
+		WritePixelArrayEx(
+			(UBYTE*)buffer, //srcRect
+			x, //SrcX
+			row, //SrcY
+			a_ctx->pitch, //SrcMod
+			rast_port, //RastPort
+			a_ctx->dest_x + x, //DestX
+			a_ctx->dest_y + row, //DestY
+			width, //SizeX
+			height, //SizeY
+			a_ctx->rect_fmt); //SrcFormat
+	}
+}
+
+/*
+ * Number of bytes present_rect() sends over the bus.
+ */
+static inline GLuint present_bytes(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height) {
+	if (a_ctx->scale_strip) {
+		GLint dx1, dy1, dx2, dy2;
+
+		scale_rect(a_ctx, x, row, width, height, &dx1, &dy1, &dx2, &dy2);
+		return (dx2 - dx1) * (dy2 - dy1) * a_ctx->pixel_bytes;
+	}
+
+	return width * height * a_ctx->pixel_bytes;
+}
+
+/*
+ * The blitter task.  It takes finished back buffers from blit_port,
+ * presents them and replies, until it gets a message without a buffer.
+ */
+static void blit_task(void) {
+	AMesaContext *a_ctx = (AMesaContext*) FindTask(NULL)->tc_UserData;
+	struct amesa_blit_msg *msg = &a_ctx->blit_msg;
+
+	a_ctx->blit_port = CreateMsgPort();
+	if (a_ctx->blit_port) {
+		// Tell amesa_display_open_async() the task is ready.
+		ReplyMsg(&msg->msg);
+
+		for (;;) {
+			WaitPort(a_ctx->blit_port);
+			msg = (struct amesa_blit_msg*) GetMsg(a_ctx->blit_port);
+			if (!msg->buffer) {
+				break;
+			}
+
+			present_rect(a_ctx, msg->buffer, msg->tiles, a_ctx->rast_port,
+					msg->x, msg->row, msg->width, msg->height);
+			ReplyMsg(&msg->msg);
+		}
+
+		DeleteMsgPort(a_ctx->blit_port);
+		a_ctx->blit_port = NULL;
+	}
+
+	// Reply under Forbid(), so the task has ended before the context can go.
+	Forbid();
+	ReplyMsg(&msg->msg);
+}
+
+/*
+ * Hand the changed area of the back buffer to the blitter task, and carry
+ * on drawing into the other one.
+ */
+static void blit_start(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height) {
+	struct amesa_blit_msg *msg = &a_ctx->blit_msg;
+
+	// The other back buffer may still be going out.
+	blit_wait(a_ctx);
+
+	msg->buffer = a_ctx->back_buffer;
+	msg->tiles = a_ctx->tiles;
+	msg->x = x;
+	msg->row = row;
+	msg->width = width;
+	msg->height = height;
+	PutMsg(a_ctx->blit_port, &msg->msg);
+	a_ctx->blit_pending = GL_TRUE;
+
+	if (a_ctx->back_buffer == a_ctx->back_buffers[0]) {
+		a_ctx->back_buffer = a_ctx->back_buffers[1];
+		a_ctx->tiles = &a_ctx->tile_maps[1];
+	} else {
+		a_ctx->back_buffer = a_ctx->back_buffers[0];
+		a_ctx->tiles = &a_ctx->tile_maps[0];
+	}
+	a_ctx->draw_buffer = a_ctx->back_buffer;
 }
 
 void amesa_display_swap_buffer(AMesaContext *a_ctx) {
-	WritePixelArrayEx(
-		(UBYTE*)a_ctx->back_buffer, //srcRect
-		0, //SrcX
-		0, //SrcY
-		a_ctx->pitch, //SrcMod
-		a_ctx->hardware_window->RPort, //RastPort
-		a_ctx->hardware_window->BorderLeft, //DestX
-		a_ctx->hardware_window->BorderTop, //DestY
-		a_ctx->width, //SizeX
-		a_ctx->height, //SizeY
-		RECTFMT_ARGB); //SrcFormat
+	struct RastPort *rast_port = a_ctx->rast_port;
+	GLboolean drawn = GL_FALSE;
+	GLint x, row, width, height;
+	PROFILE_BEGIN();
+
+	// When rendering directly the frame is already in the bitmap, only
+	// a frame that could not get the lock is left in the back buffer.
+	// A flip may have been drawn with the lock dropped by a flush since.
+	direct_unlock(a_ctx);
+	if (a_ctx->flip_drawn) {
+		dirty_reset(a_ctx);
+		drawn = GL_TRUE;
+	}
+
+	x = a_ctx->dirty_x1;
+	row = a_ctx->dirty_y1;
+	width = a_ctx->dirty_x2 - a_ctx->dirty_x1;
+	height = a_ctx->dirty_y2 - a_ctx->dirty_y1;
+
+	// A frame that went through the back buffer still has to get into the
+	// screen buffer before it can be shown.
+	if (a_ctx->flip_screen) {
+		a_ctx->flip_rport.BitMap = a_ctx->screen_buffers[a_ctx->draw_index]->sb_BitMap;
+		rast_port = &a_ctx->flip_rport;
+		drawn |= ((width > 0) && (height > 0));
+	}
+
+	// Only the part of the back buffer that changed since the last swap
+	// needs to go over the bus, the window still has the rest.
+	if ((width > 0) && (height > 0)) {
+		if (a_ctx->blit_task) {
+			blit_start(a_ctx, x, row, width, height);
+		} else {
+			present_rect(a_ctx, a_ctx->back_buffer, a_ctx->tiles, rast_port, x, row, width, height);
+		}
+
+		STATS_COUNT(a_ctx, swap_bytes, present_bytes(a_ctx, x, row, width, height));
+	}
+
+	dirty_reset(a_ctx);
+
+	if (a_ctx->flip_screen && drawn) {
+		flip_show(a_ctx);
+		a_ctx->flip_drawn = GL_FALSE;
+	}
+
+	// The next frame goes into the other half of the depth buffer.
+	if (a_ctx->depth_flip) {
+		a_ctx->depth_odd = !a_ctx->depth_odd;
+		depth_flip_apply(a_ctx);
+	}
+
+	PROFILE_END(a_ctx, swap);
+
+#ifdef AMESA_PROFILE
+	// The swap ends the frame.
+	a_ctx->last_frame_stats = a_ctx->frame_stats;
+	memset(&a_ctx->frame_stats, 0, sizeof(a_ctx->frame_stats));
+#endif
+}
+
+void amesa_display_damage(AMesaContext *a_ctx) {
+	dirty_rect(a_ctx, 0, 0, a_ctx->width, a_ctx->height);
+}
+
+GLboolean amesa_display_set_direct(AMesaContext *a_ctx, GLboolean enable) {
+	struct BitMap *bm = a_ctx->rast_port->BitMap;
+
+	if (enable == a_ctx->direct) {
+		return GL_TRUE;
+	}
+
+	if (a_ctx->flip_screen) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Page flipping always renders directly");
+		return GL_FALSE;
+	}
+
+	if (enable && a_ctx->scale_strip) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Cannot render directly at a lower resolution");
+		return GL_FALSE;
+	}
+
+	if (enable && a_ctx->blit_task) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Cannot render directly with asynchronous swaps");
+		return GL_FALSE;
+	}
+
+	if (enable) {
+		// The span functions write pixels in the layout of the back buffer,
+		// so the bitmap has to have it and be addressable as a whole.
+		if ((GetCyberMapAttr(bm, CYBRMATTR_PIXFMT) != a_ctx->fmt) ||
+				!GetCyberMapAttr(bm, CYBRMATTR_ISLINEARMEM)) {
+			_mesa_error(NULL, GL_INVALID_OPERATION, "Direct rendering needs a linear bitmap in the pixel format of the context");
+			return GL_FALSE;
+		}
+
+		tiles_touch(a_ctx, a_ctx->tiles, a_ctx->back_buffer, 0, 0, a_ctx->width, a_ctx->height);
+		a_ctx->direct = GL_TRUE;
+		a_ctx->draw_buffer = NULL;
+	} else {
+		direct_unlock(a_ctx);
+
+		a_ctx->direct = GL_FALSE;
+		a_ctx->draw_buffer = a_ctx->back_buffer;
+		a_ctx->draw_pitch = a_ctx->pitch;
+
+		// The back buffer missed everything drawn directly.
+		amesa_display_damage(a_ctx);
+	}
+
+	return GL_TRUE;
+}
+
+GLboolean amesa_display_open_flip(AMesaContext *a_ctx, GLuint buffers) {
+	struct Screen *screen;
+
+	if (!a_ctx->hardware_window) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Page flipping needs a window on the screen to flip");
+		return GL_FALSE;
+	}
+
+	if ((buffers < 2) || (buffers > AMESA_MAX_BUFFERS)) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Page flipping needs 2 or 3 buffers");
+		return GL_FALSE;
+	}
+
+	if (a_ctx->scale_strip) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Cannot page flip at a lower resolution");
+		return GL_FALSE;
+	}
+
+	if (a_ctx->blit_task) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Cannot page flip with asynchronous swaps");
+		return GL_FALSE;
+	}
+
+	screen = a_ctx->hardware_window->WScreen;
+
+	a_ctx->safe_port = CreateMsgPort();
+	if (!a_ctx->safe_port) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not create the page flip message port");
+		return GL_FALSE;
+	}
+
+	// The first buffer is the bitmap the screen was opened with, the
+	// others start out as copies of it.
+	for (GLuint i = 0; i < buffers; i++) {
+		struct ScreenBuffer *sb = AllocScreenBuffer(screen, NULL, (i == 0) ? SB_SCREEN_BITMAP : SB_COPY_BITMAP);
+
+		if (!sb) {
+			_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the screen buffers");
+			amesa_display_close_flip(a_ctx);
+			return GL_FALSE;
+		}
+
+		a_ctx->screen_buffers[i] = sb;
+		sb->sb_DBufInfo->dbi_SafeMessage.mn_ReplyPort = a_ctx->safe_port;
+
+		if ((GetCyberMapAttr(sb->sb_BitMap, CYBRMATTR_PIXFMT) != a_ctx->fmt) ||
+				!GetCyberMapAttr(sb->sb_BitMap, CYBRMATTR_ISLINEARMEM)) {
+			_mesa_error(NULL, GL_INVALID_OPERATION, "Page flipping needs a linear screen bitmap");
+			amesa_display_close_flip(a_ctx);
+			return GL_FALSE;
+		}
+	}
+
+	InitRastPort(&a_ctx->flip_rport);
+
+	a_ctx->flip_screen = screen;
+	a_ctx->buffers = buffers;
+	a_ctx->display_index = 0;
+	a_ctx->draw_index = 1;
+	a_ctx->flips_pending = 0;
+	a_ctx->flip_drawn = GL_FALSE;
+
+	// Frames are drawn straight into the screen buffers, which clears do
+	// not defer.
+	tiles_touch(a_ctx, a_ctx->tiles, a_ctx->back_buffer, 0, 0, a_ctx->width, a_ctx->height);
+	a_ctx->direct = GL_TRUE;
+	a_ctx->draw_buffer = NULL;
+
+	return GL_TRUE;
+}
+
+void amesa_display_close_flip(AMesaContext *a_ctx) {
+	struct Screen *screen;
+
+	if (!a_ctx->safe_port) {
+		return;
+	}
+
+	screen = a_ctx->hardware_window->WScreen;
+
+	if (a_ctx->flip_screen) {
+		direct_unlock(a_ctx);
+
+		// The screen has to show its own bitmap again before the other
+		// buffers can go.
+		if (a_ctx->display_index != 0) {
+			while (!ChangeScreenBuffer(screen, a_ctx->screen_buffers[0])) {
+				WaitTOF();
+			}
+			a_ctx->flips_pending++;
+		}
+
+		// Intuition may not touch the buffers after they are freed.
+		while (a_ctx->flips_pending > 0) {
+			WaitPort(a_ctx->safe_port);
+			while (GetMsg(a_ctx->safe_port)) {
+				a_ctx->flips_pending--;
+			}
+		}
+
+		a_ctx->flip_screen = NULL;
+		a_ctx->flip_drawn = GL_FALSE;
+		a_ctx->direct = GL_FALSE;
+		a_ctx->draw_buffer = a_ctx->back_buffer;
+		a_ctx->draw_pitch = a_ctx->pitch;
+	}
+
+	for (GLuint i = 0; i < AMESA_MAX_BUFFERS; i++) {
+		if (a_ctx->screen_buffers[i]) {
+			FreeScreenBuffer(screen, a_ctx->screen_buffers[i]);
+			a_ctx->screen_buffers[i] = NULL;
+		}
+	}
+
+	DeleteMsgPort(a_ctx->safe_port);
+	a_ctx->safe_port = NULL;
+}
+
+GLboolean amesa_display_open_async(AMesaContext *a_ctx) {
+	if (a_ctx->blit_task) {
+		return GL_TRUE;
+	}
+
+	if (a_ctx->direct) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Asynchronous swaps need a back buffer");
+		return GL_FALSE;
+	}
+
+	a_ctx->back_buffers[0] = a_ctx->back_buffer;
+	a_ctx->back_buffers[1] = AllocVec((a_ctx->height * a_ctx->pitch), MEMF_PUBLIC|MEMF_CLEAR);
+	a_ctx->tile_maps[1].cleared = AllocVec(a_ctx->tiles_x * a_ctx->tiles_y, MEMF_PUBLIC|MEMF_CLEAR);
+	a_ctx->blit_reply_port = CreateMsgPort();
+	if (!a_ctx->back_buffers[1] || !a_ctx->tile_maps[1].cleared || !a_ctx->blit_reply_port) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the second back buffer");
+		amesa_display_close_async(a_ctx);
+		return GL_FALSE;
+	}
+
+	a_ctx->blit_msg.msg.mn_ReplyPort = a_ctx->blit_reply_port;
+	a_ctx->blit_msg.msg.mn_Length = sizeof(struct amesa_blit_msg);
+
+	// The task can't run before it knows its context.
+	Forbid();
+	a_ctx->blit_task = CreateTask("Amiga Mesa blitter", 0, (APTR) blit_task, BLIT_STACK_SIZE);
+	if (a_ctx->blit_task) {
+		a_ctx->blit_task->tc_UserData = a_ctx;
+	}
+	Permit();
+
+	if (!a_ctx->blit_task) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not create the blitter task");
+		amesa_display_close_async(a_ctx);
+		return GL_FALSE;
+	}
+
+	// Wait for it to start, it has ended again if it has no port.
+	WaitPort(a_ctx->blit_reply_port);
+	GetMsg(a_ctx->blit_reply_port);
+
+	if (!a_ctx->blit_port) {
+		a_ctx->blit_task = NULL;
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not create the blitter message port");
+		amesa_display_close_async(a_ctx);
+		return GL_FALSE;
+	}
+
+	return GL_TRUE;
+}
+
+GLboolean amesa_display_set_depth_flip(AMesaContext *a_ctx, GLuint mode) {
+	if (mode > AMESA_DEPTHFLIP_NOCLEAR) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Unknown depth flip mode");
+		return GL_FALSE;
+	}
+
+	if (mode && !a_ctx->gl_ctx->Visual.depthBits) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Depth flipping needs a depth buffer");
+		return GL_FALSE;
+	}
+
+	a_ctx->depth_flip = mode;
+	a_ctx->depth_odd = GL_FALSE;
+	a_ctx->depth_primed = GL_FALSE;
+	depth_flip_apply(a_ctx);
+
+	return GL_TRUE;
+}
+
+void amesa_display_set_fixed_point(AMesaContext *a_ctx, GLboolean enable) {
+	a_ctx->fixed_point = enable;
+
+	// Have swrast choose the triangle function again.
+	amesa_display_update_state(a_ctx->gl_ctx, _NEW_POLYGON);
+}
+
+GLboolean amesa_display_set_tex_subdivide(AMesaContext *a_ctx, GLuint pixels) {
+	if ((pixels != 0) && (pixels != 8) && (pixels != 16)) {
+		_mesa_error(NULL, GL_INVALID_VALUE, "Textures can only be subdivided every 8 or 16 pixels");
+		return GL_FALSE;
+	}
+
+	a_ctx->tex_subdivide = pixels;
+	amesa_display_update_state(a_ctx->gl_ctx, _NEW_HINT);
+
+	return GL_TRUE;
+}
+
+void amesa_display_close_async(AMesaContext *a_ctx) {
+	if (a_ctx->blit_task) {
+		blit_wait(a_ctx);
+
+		a_ctx->blit_msg.buffer = NULL;
+		PutMsg(a_ctx->blit_port, &a_ctx->blit_msg.msg);
+		WaitPort(a_ctx->blit_reply_port);
+		GetMsg(a_ctx->blit_reply_port);
+		a_ctx->blit_task = NULL;
+	}
+
+	if (a_ctx->back_buffers[1]) {
+		// Back to the first back buffer, which may be a frame behind.
+		a_ctx->back_buffer = a_ctx->back_buffers[0];
+		a_ctx->draw_buffer = a_ctx->back_buffer;
+		amesa_display_damage(a_ctx);
+
+		FreeVec(a_ctx->back_buffers[1]);
+		a_ctx->back_buffers[1] = NULL;
+	}
+	a_ctx->back_buffers[0] = NULL;
+	a_ctx->tiles = &a_ctx->tile_maps[0];
+
+	if (a_ctx->tile_maps[1].cleared) {
+		FreeVec(a_ctx->tile_maps[1].cleared);
+		a_ctx->tile_maps[1].cleared = NULL;
+		a_ctx->tile_maps[1].count = 0;
+	}
+
+	if (a_ctx->blit_reply_port) {
+		DeleteMsgPort(a_ctx->blit_reply_port);
+		a_ctx->blit_reply_port = NULL;
+	}
 }
 
 GLboolean amesa_display_init(AMesaContext *a_ctx) {
 	_mesa_debug(NULL, "amesa_display_init()....\n");
 
 	// Seed the clear color.
-	a_ctx->clear_color = TC_ARGB32(0, 0, 0, 255);
+	a_ctx->clear_color = pack_color(a_ctx, 0, 0, 0, 255);
+	a_ctx->clear_argb = TC_ARGB32(0, 0, 0, 255);
+	if (a_ctx->pixel_bytes == 2) {
+		a_ctx->clear_color |= a_ctx->clear_color << 16;
+	}
 
-	// Create our pixel buffers.
-	a_ctx->clear_buffer = AllocVec((a_ctx->height * a_ctx->pitch), MEMF_PUBLIC|MEMF_CLEAR);
+	// Where the driver rasterizers put each component of 32-bit pixels.
+	switch (a_ctx->fmt) {
+	case PIXFMT_BGRA32:
+		a_ctx->shift[RCOMP] = 8;
+		a_ctx->shift[GCOMP] = 16;
+		a_ctx->shift[BCOMP] = 24;
+		a_ctx->shift[ACOMP] = 0;
+		break;
+	case PIXFMT_RGBA32:
+		a_ctx->shift[RCOMP] = 24;
+		a_ctx->shift[GCOMP] = 16;
+		a_ctx->shift[BCOMP] = 8;
+		a_ctx->shift[ACOMP] = 0;
+		break;
+	default:
+		a_ctx->shift[RCOMP] = 16;
+		a_ctx->shift[GCOMP] = 8;
+		a_ctx->shift[BCOMP] = 0;
+		a_ctx->shift[ACOMP] = 24;
+		break;
+	}
+
+	// The back buffer has the layout of the screen, ARGB and RGBA have a
+	// rectangle format of their own and anything else (including 15/16-bit)
+	// is copied raw.
+	switch (a_ctx->fmt) {
+	case PIXFMT_ARGB32:
+		a_ctx->rect_fmt = RECTFMT_ARGB;
+		break;
+	case PIXFMT_RGBA32:
+		a_ctx->rect_fmt = RECTFMT_RGBA;
+		break;
+	default:
+		a_ctx->rect_fmt = RECTFMT_RAW;
+		break;
+	}
+
+	// Create our pixel buffer.
 	a_ctx->back_buffer = AllocVec((a_ctx->height * a_ctx->pitch), MEMF_PUBLIC|MEMF_CLEAR);
+	if (!a_ctx->back_buffer) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the pixel buffers");
+		return GL_FALSE;
+	}
+
+	a_ctx->draw_buffer = a_ctx->back_buffer;
+	a_ctx->draw_pitch = a_ctx->pitch;
+
+	// Nothing is cleared yet.
+	a_ctx->tiles_x = (a_ctx->width + TILE_SIZE - 1) >> TILE_SHIFT;
+	a_ctx->tiles_y = (a_ctx->height + TILE_SIZE - 1) >> TILE_SHIFT;
+	a_ctx->tiles = &a_ctx->tile_maps[0];
+	a_ctx->tiles->cleared = AllocVec(a_ctx->tiles_x * a_ctx->tiles_y, MEMF_PUBLIC|MEMF_CLEAR);
+	if (!a_ctx->tiles->cleared) {
+		_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the tile flags");
+		return GL_FALSE;
+	}
+
+	// Rendering at a lower resolution than the display.
+	if ((a_ctx->width != a_ctx->display_width) || (a_ctx->height != a_ctx->display_height)) {
+		a_ctx->scale_pitch = ((a_ctx->display_width * a_ctx->pixel_bytes) + 3) & ~3;
+		a_ctx->scale_strip = AllocVec(SCALE_STRIP_ROWS * a_ctx->scale_pitch, MEMF_PUBLIC);
+		a_ctx->scale_map = AllocVec(a_ctx->display_width * sizeof(GLushort), MEMF_PUBLIC);
+		if (!a_ctx->scale_strip || !a_ctx->scale_map) {
+			_mesa_error(NULL, GL_OUT_OF_MEMORY, "Could not allocate the scaling buffers");
+			return GL_FALSE;
+		}
+
+		for (GLuint i = 0; i < a_ctx->display_width; i++) {
+			a_ctx->scale_map[i] = (i * a_ctx->width) / a_ctx->display_width;
+		}
+	}
+
+	// The first swap has to present everything.
+	amesa_display_damage(a_ctx);
+
+	a_ctx->depth_func = a_ctx->gl_ctx->Depth.Func;
+	a_ctx->depth_test = a_ctx->depth_func;
 
 	amesa_display_init_pointers(a_ctx->gl_ctx);
 
+	// Opened last, amesa_display_shutdown() only closes it again once
+	// amesa_display_wakeup() hooked up the render timing.
+#ifdef AMESA_PROFILE
+	if (!amesa_timer_open()) {
+		_mesa_error(NULL, GL_INVALID_OPERATION, "Could not open the timer for profiling");
+		return GL_FALSE;
+	}
+#endif
+
 	_mesa_debug(NULL, "amesa_display_init() - All is cool\n");
 	return GL_TRUE;
 }
@@ -438,14 +2111,51 @@ GLboolean amesa_display_init(AMesaContext *a_ctx) {
 void amesa_display_shutdown(AMesaContext *a_ctx) {
 	_mesa_debug(NULL, "amesa_display_shutdown()....\n");
 
+	amesa_display_close_async(a_ctx);
+	amesa_display_close_flip(a_ctx);
+	direct_unlock(a_ctx);
+	a_ctx->draw_buffer = NULL;
+
 	if (a_ctx->back_buffer) {
 		FreeVec(a_ctx->back_buffer);
 		a_ctx->back_buffer = NULL;
 	}
 
-	if (a_ctx->clear_buffer) {
-		FreeVec(a_ctx->clear_buffer);
-		a_ctx->clear_buffer = NULL;
+	if (a_ctx->tile_maps[0].cleared) {
+		FreeVec(a_ctx->tile_maps[0].cleared);
+		a_ctx->tile_maps[0].cleared = NULL;
+		a_ctx->tile_maps[0].count = 0;
 	}
+
+	if (a_ctx->scale_strip) {
+		FreeVec(a_ctx->scale_strip);
+		a_ctx->scale_strip = NULL;
+	}
+
+	if (a_ctx->scale_map) {
+		FreeVec(a_ctx->scale_map);
+		a_ctx->scale_map = NULL;
+	}
+
+#ifdef AMESA_PROFILE
+	if (a_ctx->render_start) {
+		amesa_timer_close();
+		a_ctx->render_start = NULL;
+	}
+#endif
+}
+
+// Hook up swsetup now that the display is ready.
+void amesa_display_wakeup(AMesaContext *a_ctx) {
+	TNLcontext *tnl_ctx = TNL_CONTEXT(a_ctx->gl_ctx);
+
+	_swsetup_Wakeup(a_ctx->gl_ctx);
+
+	// Wrap the render hooks installed by swsetup to blend in the span
+	// functions and time rasterization.
+	a_ctx->render_start = tnl_ctx->Driver.Render.Start;
+	a_ctx->render_finish = tnl_ctx->Driver.Render.Finish;
+	tnl_ctx->Driver.Render.Start = render_start;
+	tnl_ctx->Driver.Render.Finish = render_finish;
 }
 
@@ -5,9 +5,22 @@
 
 GLboolean amesa_display_init(AMesaContext *a_ctx);
 extern void amesa_display_shutdown(AMesaContext *a_ctx);
+extern void amesa_display_wakeup(AMesaContext *a_ctx);
 
 extern void amesa_display_update_state(GLcontext *gl_ctx, GLuint new_state);
 extern void amesa_display_swap_buffer(AMesaContext *a_ctx);
+extern void amesa_display_damage(AMesaContext *a_ctx);
+extern GLboolean amesa_display_set_direct(AMesaContext *a_ctx, GLboolean enable);
+extern GLboolean amesa_display_open_flip(AMesaContext *a_ctx, GLuint buffers);
+extern void amesa_display_close_flip(AMesaContext *a_ctx);
+extern GLboolean amesa_display_open_async(AMesaContext *a_ctx);
+extern void amesa_display_close_async(AMesaContext *a_ctx);
+extern GLboolean amesa_display_set_depth_flip(AMesaContext *a_ctx, GLuint mode);
+extern void amesa_display_set_fixed_point(AMesaContext *a_ctx, GLboolean enable);
+extern GLboolean amesa_display_set_tex_subdivide(AMesaContext *a_ctx, GLuint pixels);
+extern void amesa_display_draw_rect(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height);
+extern void amesa_display_touch_tiles(AMesaContext *a_ctx, GLint x, GLint row, GLint width, GLint height);
+extern void amesa_display_touch_line(AMesaContext *a_ctx, GLint x0, GLint row0, GLint x1, GLint row1);
 
 
 #endif
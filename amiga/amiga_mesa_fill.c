@@ -0,0 +1,88 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <GL/gl.h>
+#include "amiga_mesa_fill.h"
+#include "amiga_mesa_simd.h"
+
+// Cache line size of the 68040 and 68060, the stores are lined up on it.
+#define FILL_LINE 16
+
+void amesa_fill(GLubyte *dst, GLuint bytes, GLuint value) {
+	GLuint *d;
+
+#ifdef AMESA_SIMD
+	if (amesa_simd.fill) {
+		amesa_simd.fill(dst, bytes, value);
+		return;
+	}
+#endif
+
+	// A 16-bit pixel up to the first longword
+	if ((((unsigned long) dst) & 2) && (bytes >= 2)) {
+		*(GLushort*) dst = (GLushort) value;
+		dst += 2;
+		bytes -= 2;
+	}
+
+	// Longwords up to the first cache line
+	d = (GLuint*) dst;
+	while ((((unsigned long) d) & (FILL_LINE - 1)) && (bytes >= 4)) {
+		*d++ = value;
+		bytes -= 4;
+	}
+
+	// Two whole lines per iteration, so the line is written back in one
+	// burst and the loop overhead is spread over 8 stores.
+	for (; bytes >= 2 * FILL_LINE; bytes -= 2 * FILL_LINE) {
+		d[0] = value;
+		d[1] = value;
+		d[2] = value;
+		d[3] = value;
+		d[4] = value;
+		d[5] = value;
+		d[6] = value;
+		d[7] = value;
+		d += 8;
+	}
+
+	for (; bytes >= 4; bytes -= 4) {
+		*d++ = value;
+	}
+
+	// And a 16-bit pixel left over
+	if (bytes >= 2) {
+		*(GLushort*) d = (GLushort) value;
+	}
+}
+
+void amesa_fill_rows(GLubyte *dst, GLuint pitch, GLuint bytes, GLuint rows, GLuint value) {
+	// Rows without padding are one long run.
+	if (pitch == bytes) {
+		amesa_fill(dst, bytes * rows, value);
+		return;
+	}
+
+	for (GLuint row = 0; row < rows; row++) {
+		amesa_fill(dst, bytes, value);
+		dst += pitch;
+	}
+}
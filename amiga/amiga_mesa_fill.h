@@ -0,0 +1,23 @@
+
+#ifndef AMIGA_MESA_FILL_H
+#define AMIGA_MESA_FILL_H
+
+/*
+ * Fill kernels for clearing pixel buffers.
+ *
+ * The value is a 32-bit pattern, 16-bit pixels must be replicated into
+ * both halves of it.  The destination must be aligned to the pixel size
+ * and the byte counts must be whole pixels.
+ */
+
+/*
+ * Fill 'bytes' bytes at dst.
+ */
+extern void amesa_fill(GLubyte *dst, GLuint bytes, GLuint value);
+
+/*
+ * Fill 'bytes' bytes of 'rows' rows, pitch bytes apart.
+ */
+extern void amesa_fill_rows(GLubyte *dst, GLuint pitch, GLuint bytes, GLuint rows, GLuint value);
+
+#endif
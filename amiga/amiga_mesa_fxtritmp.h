@@ -0,0 +1,365 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Triangle rasterized with integer arithmetic only, for CPUs without an
+ * FPU.  This file is included by amiga_mesa_tri.c once per triangle
+ * function, with these defined:
+ *
+ *   NAME              - name of the triangle function
+ *   INTERP_Z          - define to interpolate depth, with DEPTH_TYPE the
+ *                       type of the depth buffer
+ *   INTERP_RGBA       - define to interpolate the color and alpha
+ *   INTERP_TEX        - define to interpolate the coordinates of texture 0,
+ *                       with S_LOG2 and T_LOG2 the log2 of its width and
+ *                       height, and TEX_FALLBACK the triangle function
+ *                       drawing triangles with q or 1/w at or below 0
+ *   SETUP_CODE        - code run once the triangle is known to be drawn
+ *   RENDER_SPAN(span) - code drawing the struct fx_span 'span' at pRow,
+ *                       and zRow with INTERP_Z
+ *
+ * Vertices are snapped to 1/256 pixel (24.8) and the edges walked in 16.16
+ * fixed point.  The gradients are solved with 64-bit integers once per triangle,
+ * then stepped with 32-bit adds down the left edge and along the spans.
+ * Color and depth are GLfixed like in swrast's spans.  Texture coordinates
+ * go as s * q, t * q and q, scaled to fit in 32 bits, and are set up from
+ * the bits of the floats.  Reading the vertices is the only floating point
+ * left.
+ */
+
+#if defined(INTERP_Z) || defined(INTERP_RGBA) || defined(INTERP_TEX)
+#define FX_ATTRIBS
+#endif
+
+/*
+ * Bits of subpixel precision of the vertices.
+ */
+#define FX_BITS 8
+#define FX_ONE (1 << FX_BITS)
+#define FX_HALF (1 << (FX_BITS - 1))
+
+#ifdef INTERP_Z
+#define FixedToDepth(F) ((F) >> FIXED_SHIFT)
+#endif
+
+/*
+ * Gradients of an attribute per pixel.
+ */
+#define FX_GRADIENT(N, v) { \
+	const long long d1 = (v)[2] - (v)[0]; \
+	const long long d2 = (v)[1] - (v)[0]; \
+	span.N##Step = (GLint) ((d1 * e2y - d2 * e1y) * FX_ONE / area); \
+	N##_dy = (GLint) ((d2 * e1x - d1 * e2x) * FX_ONE / area); \
+}
+
+/*
+ * An attribute at the start of the span, solved from the plane through the
+ * vertices on the first row and stepped from the row before on the others.
+ * The step wraps around unsigned, as it can overflow on slivers even though
+ * the result does not.
+ */
+#define FX_ROW(N, v) \
+	if (first) { \
+		N##_row = (v)[0] + (GLint) (((long long) span.N##Step * px + (long long) N##_dy * py) >> FX_BITS); \
+	} else { \
+		N##_row = (GLint) ((GLuint) N##_row + (GLuint) N##_dy + (GLuint) span.N##Step * (GLuint) dx); \
+	} \
+	span.N = N##_row
+
+/*
+ * Keep a color within range at both ends of the span, like swrast does.
+ */
+#define FX_CLAMP(N) { \
+	const GLfixed last = span.N + (GLint) (span.end - 1) * span.N##Step; \
+	if (last < 0) { \
+		span.N -= last; \
+	} else if (last > ChanToFixed(CHAN_MAX)) { \
+		span.N -= last - ChanToFixed(CHAN_MAX); \
+	} \
+	span.N = CLAMP(span.N, 0, ChanToFixed(CHAN_MAX)); \
+}
+
+static void NAME(GLcontext *ctx, const SWvertex *v0, const SWvertex *v1, const SWvertex *v2) {
+	AMesaContext *a_ctx = (AMesaContext*) ctx->DriverCtx;
+	RASTER_SHIFTS(a_ctx);
+	const SWvertex *vert[3];
+	GLint vx[3], vy[3]; /* 24.8, sorted by y */
+	GLint e1x, e1y, e2x, e2y;
+	long long area;
+	GLint row, row_mid, row_end;
+	GLint major_x, major_step, minor_x, minor_step;
+#ifdef FX_ATTRIBS
+	GLint last_x = 0;
+	GLboolean first = GL_TRUE;
+#endif
+	struct fx_span span;
+#ifdef INTERP_Z
+	GLfixed zv[3], z_dy, z_row = 0;
+#endif
+#ifdef INTERP_RGBA
+	GLfixed rv[3], gv[3], bv[3], av[3];
+	GLfixed red_dy, green_dy, blue_dy, alpha_dy;
+	GLfixed red_row = 0, green_row = 0, blue_row = 0, alpha_row = 0;
+#endif
+#ifdef INTERP_TEX
+	GLint sv[3], tv[3], qv[3];
+	GLint s_dy, t_dy, q_dy, s_row = 0, t_row = 0, q_row = 0;
+#endif
+
+	if (IS_INF_OR_NAN(v0->win[0] + v0->win[1] + v1->win[0] + v1->win[1] + v2->win[0] + v2->win[1])) {
+		return;
+	}
+
+#ifdef INTERP_TEX
+	// The texture setup below needs q and 1/w above 0, which projective
+	// texturing does not have to keep to.
+	if (!fx_positive(v0->texcoord[0][3]) || !fx_positive(v1->texcoord[0][3]) || !fx_positive(v2->texcoord[0][3]) ||
+			!fx_positive(v0->win[3]) || !fx_positive(v1->win[3]) || !fx_positive(v2->win[3])) {
+		TEX_FALLBACK(ctx, v0, v1, v2);
+		return;
+	}
+#endif
+
+	vert[0] = v0;
+	vert[1] = v1;
+	vert[2] = v2;
+	for (GLuint i = 0; i < 3; i++) {
+		vx[i] = IROUND(vert[i]->win[0] * (GLfloat) FX_ONE);
+		vy[i] = IROUND(vert[i]->win[1] * (GLfloat) FX_ONE);
+	}
+
+	// Cull with swrast's sign, positive areas are counterclockwise.
+	area = (long long) (vx[1] - vx[0]) * (vy[2] - vy[0]) - (long long) (vx[2] - vx[0]) * (vy[1] - vy[0]);
+	if ((area == 0) || ((area > 0) ? (a_ctx->cull_sign > 0) : (a_ctx->cull_sign < 0))) {
+		return;
+	}
+
+	// Sort by y.
+	for (GLuint i = 0; i < 2; i++) {
+		for (GLuint j = 2; j > i; j--) {
+			if (vy[j] < vy[j - 1]) {
+				const SWvertex *v = vert[j];
+				const GLint x = vx[j], y = vy[j];
+
+				vert[j] = vert[j - 1];
+				vx[j] = vx[j - 1];
+				vy[j] = vy[j - 1];
+				vert[j - 1] = v;
+				vx[j - 1] = x;
+				vy[j - 1] = y;
+			}
+		}
+	}
+
+	// Edge 1 is the long one from the bottom vertex to the top one,
+	// edge 2 goes to the middle vertex.  The long edge is on the left
+	// when the area between them is negative.
+	e1x = vx[2] - vx[0];
+	e1y = vy[2] - vy[0];
+	e2x = vx[1] - vx[0];
+	e2y = vy[1] - vy[0];
+	area = (long long) e1x * e2y - (long long) e2x * e1y;
+
+	{
+#ifdef SETUP_CODE
+		SETUP_CODE
+#endif
+
+#ifdef INTERP_Z
+		for (GLuint i = 0; i < 3; i++) {
+			zv[i] = FloatToFixed(vert[i]->win[2]) + FIXED_HALF;
+		}
+#endif
+#ifdef INTERP_RGBA
+		for (GLuint i = 0; i < 3; i++) {
+			rv[i] = ChanToFixed(vert[i]->color[RCOMP]);
+			gv[i] = ChanToFixed(vert[i]->color[GCOMP]);
+			bv[i] = ChanToFixed(vert[i]->color[BCOMP]);
+			av[i] = ChanToFixed(vert[i]->color[ACOMP]);
+		}
+#endif
+#ifdef INTERP_TEX
+		{
+			// Texel coordinates are biased by whole textures so they are
+			// at least a texture width above 0 everywhere, and q is scaled
+			// by powers of two so neither s * q nor t * q can overflow.
+			long long s[3], t[3], q[3], sbias, tbias, m, qmax;
+			GLint qm[3], qe[3], emax, k = 0;
+
+			for (GLuint i = 0; i < 3; i++) {
+				const GLfloat *tc = vert[i]->texcoord[0];
+				GLint sm, se, tm, te, rm, re, wm, we;
+
+				fx_float(tc[0], &sm, &se);
+				fx_float(tc[1], &tm, &te);
+				fx_float(tc[3], &rm, &re);
+				fx_float(vert[i]->win[3], &wm, &we);
+
+				// s / q and t / q in texels as 16.16, q is mostly 1.0 here.
+				if (rm != 0x800000) {
+					sm = (GLint) (((long long) sm * 0x800000) / rm);
+					tm = (GLint) (((long long) tm * 0x800000) / rm);
+				}
+				s[i] = fx_scale(sm, se - re - 23 + 16 + S_LOG2);
+				t[i] = fx_scale(tm, te - re - 23 + 16 + T_LOG2);
+				qm[i] = (GLint) (((long long) rm * wm) >> 23);
+				qe[i] = re + we + 23;
+			}
+
+			sbias = ((-MIN2(s[0], MIN2(s[1], s[2])) >> (16 + S_LOG2)) + 2) * (1LL << (16 + S_LOG2));
+			tbias = ((-MIN2(t[0], MIN2(t[1], t[2])) >> (16 + T_LOG2)) + 2) * (1LL << (16 + T_LOG2));
+			emax = MAX2(qe[0], MAX2(qe[1], qe[2]));
+			m = 0;
+			for (GLuint i = 0; i < 3; i++) {
+				s[i] += sbias;
+				t[i] += tbias;
+				m = MAX2(m, MAX2(s[i], t[i]));
+				q[i] = fx_scale(qm[i], qe[i] - emax);
+			}
+
+			qmax = MAX2(q[0], MAX2(q[1], q[2]));
+			if (qmax >> 24) {
+				k = 1;
+			}
+			while ((((m >> 16) + 1) * (qmax >> k)) > (1LL << 30)) {
+				k++;
+			}
+
+			for (GLuint i = 0; i < 3; i++) {
+				qv[i] = (GLint) (q[i] >> k);
+				sv[i] = (GLint) ((s[i] * qv[i]) >> 16);
+				tv[i] = (GLint) ((t[i] * qv[i]) >> 16);
+			}
+		}
+#endif
+
+		fx_tri_begin(a_ctx, MIN2(vx[0], MIN2(vx[1], vx[2])), vy[0], MAX2(vx[0], MAX2(vx[1], vx[2])), vy[2]);
+
+#ifdef INTERP_Z
+		FX_GRADIENT(z, zv);
+#endif
+#ifdef INTERP_RGBA
+		FX_GRADIENT(red, rv);
+		FX_GRADIENT(green, gv);
+		FX_GRADIENT(blue, bv);
+		FX_GRADIENT(alpha, av);
+#endif
+#ifdef INTERP_TEX
+		FX_GRADIENT(s, sv);
+		FX_GRADIENT(t, tv);
+		FX_GRADIENT(q, qv);
+#endif
+
+		// Rows whose pixel centers lie between the vertices.
+		row = (vy[0] + FX_HALF - 1) >> FX_BITS;
+		row_mid = (vy[1] + FX_HALF - 1) >> FX_BITS;
+		row_end = (vy[2] + FX_HALF - 1) >> FX_BITS;
+
+		major_step = (GLint) ((long long) e1x * 65536 / e1y);
+		major_x = (vx[0] << (16 - FX_BITS)) +
+				(GLint) (((long long) (row * FX_ONE + FX_HALF - vy[0]) * major_step) >> FX_BITS);
+
+		for (GLuint half = 0; half < 2; half++) {
+			const GLint a = half, b = half + 1;
+			const GLint half_end = half ? row_end : row_mid;
+
+			if (row >= half_end) {
+				continue;
+			}
+
+			minor_step = (GLint) ((long long) (vx[b] - vx[a]) * 65536 / (vy[b] - vy[a]));
+			minor_x = (vx[a] << (16 - FX_BITS)) +
+					(GLint) (((long long) (row * FX_ONE + FX_HALF - vy[a]) * minor_step) >> FX_BITS);
+
+			for (; row < half_end; row++) {
+				const GLint left = (area < 0) ? major_x : minor_x;
+				const GLint right = (area < 0) ? minor_x : major_x;
+				const GLint x = (left + 0x7fff) >> 16;
+#ifdef FX_ATTRIBS
+				const GLint dx = x - last_x;
+				const GLint px = x * FX_ONE + FX_HALF - vx[0];
+				const GLint py = row * FX_ONE + FX_HALF - vy[0];
+#endif
+
+				span.x = x;
+				span.y = row;
+				span.end = MAX2(((right + 0x7fff) >> 16) - x, 0);
+
+#ifdef INTERP_Z
+				FX_ROW(z, zv);
+#endif
+#ifdef INTERP_RGBA
+				FX_ROW(red, rv);
+				FX_ROW(green, gv);
+				FX_ROW(blue, bv);
+				FX_ROW(alpha, av);
+#endif
+#ifdef INTERP_TEX
+				FX_ROW(s, sv);
+				FX_ROW(t, tv);
+				FX_ROW(q, qv);
+#endif
+#ifdef FX_ATTRIBS
+				first = GL_FALSE;
+				last_x = x;
+#endif
+
+				if (span.end > 0) {
+					PIXEL_TYPE *pRow = (PIXEL_TYPE*) PIXEL_ADDRESS(span.x, span.y);
+#ifdef INTERP_Z
+					DEPTH_TYPE *zRow = (DEPTH_TYPE*) _mesa_zbuffer_address(ctx, span.x, span.y);
+#endif
+#ifdef INTERP_RGBA
+					FX_CLAMP(red);
+					FX_CLAMP(green);
+					FX_CLAMP(blue);
+					FX_CLAMP(alpha);
+#endif
+					RENDER_SPAN(span);
+				}
+
+				major_x += major_step;
+				minor_x += minor_step;
+			}
+		}
+	}
+}
+
+#undef FX_ATTRIBS
+#undef FX_BITS
+#undef FX_ONE
+#undef FX_HALF
+#undef FX_GRADIENT
+#undef FX_ROW
+#undef FX_CLAMP
+#undef FixedToDepth
+#undef NAME
+#undef INTERP_Z
+#undef INTERP_RGBA
+#undef INTERP_TEX
+#undef S_LOG2
+#undef T_LOG2
+#undef TEX_FALLBACK
+#undef DEPTH_TYPE
+#undef PIXEL_TYPE
+#undef PIXEL_ADDRESS
+#undef SETUP_CODE
+#undef RENDER_SPAN
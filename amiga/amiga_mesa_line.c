@@ -0,0 +1,178 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Line and point rasterizers that write 32-bit pixels straight into the
+ * draw buffer.
+ */
+
+#include <GL/amiga_mesa.h>
+#include "amiga_mesa_def.h"
+#include "amiga_mesa_display.h"
+#include "amiga_mesa_raster.h"
+
+#include "glheader.h"
+#include "macros.h"
+#include "texformat.h"
+#include "swrast/s_context.h"
+#include "swrast/s_depth.h"
+#include "swrast/s_lines.h"
+#include "swrast/s_points.h"
+
+#define NAME flat_line
+#include "amiga_mesa_linetmp.h"
+
+#define NAME smooth_line
+#define INTERP_RGBA
+#include "amiga_mesa_linetmp.h"
+
+#define NAME flat_z_line
+#define INTERP_Z
+#include "amiga_mesa_linetmp.h"
+
+#define NAME smooth_z_line
+#define INTERP_Z
+#define INTERP_RGBA
+#include "amiga_mesa_linetmp.h"
+
+/*
+ * The line function for the current state, NULL if swrast has to draw it.
+ * Only plain one pixel wide lines are done here.
+ */
+static swrast_line_func get_line_func(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	GLuint raster_mask = SWRAST_CONTEXT(gl_ctx)->_RasterMask;
+	GLboolean depth = GL_FALSE;
+
+	if (!raster_usable(a_ctx) || gl_ctx->Line.SmoothFlag || gl_ctx->Line.StippleFlag ||
+			(gl_ctx->Line.Width != 1.0F)) {
+		return NULL;
+	}
+
+	if (raster_mask & DEPTH_BIT) {
+		if (!raster_depth_setup(a_ctx)) {
+			return NULL;
+		}
+		raster_mask &= ~DEPTH_BIT;
+		depth = GL_TRUE;
+	}
+
+	// Texturing, blending, fog, clipping and the like.
+	if (raster_mask) {
+		return NULL;
+	}
+
+	if (gl_ctx->Light.ShadeModel == GL_SMOOTH) {
+		return depth ? smooth_z_line : smooth_line;
+	} else {
+		return depth ? flat_z_line : flat_line;
+	}
+}
+
+/*
+ * swrast choose_line hook.
+ */
+void amesa_choose_line(GLcontext *gl_ctx) {
+	SWcontext *swrast = SWRAST_CONTEXT(gl_ctx);
+
+	if (!(swrast->Line = get_line_func(gl_ctx))) {
+		_swrast_choose_line(gl_ctx);
+	}
+}
+
+#define NAME point
+#include "amiga_mesa_pointtmp.h"
+
+#define NAME z_point
+#define INTERP_Z
+#include "amiga_mesa_pointtmp.h"
+
+#define NAME sized_point
+#define SIZED
+#include "amiga_mesa_pointtmp.h"
+
+#define NAME sized_z_point
+#define SIZED
+#define INTERP_Z
+#include "amiga_mesa_pointtmp.h"
+
+#define NAME sprite_point
+#define SIZED
+#define SPRITE
+#include "amiga_mesa_pointtmp.h"
+
+#define NAME sprite_z_point
+#define SIZED
+#define SPRITE
+#define INTERP_Z
+#include "amiga_mesa_pointtmp.h"
+
+/*
+ * The point function for the current state, NULL if swrast has to draw it.
+ * Square points of a fixed size are done here, textured only as sprites.
+ */
+static swrast_point_func get_point_func(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	GLuint raster_mask = SWRAST_CONTEXT(gl_ctx)->_RasterMask;
+	GLboolean depth = GL_FALSE;
+
+	if (!raster_usable(a_ctx) || gl_ctx->Point.SmoothFlag || gl_ctx->Point._Attenuated) {
+		return NULL;
+	}
+
+	if (raster_mask & DEPTH_BIT) {
+		if (!raster_depth_setup(a_ctx)) {
+			return NULL;
+		}
+		raster_mask &= ~DEPTH_BIT;
+		depth = GL_TRUE;
+	}
+
+	if (raster_mask & TEXTURE_BIT) {
+		if ((raster_mask & ~TEXTURE_BIT) || !gl_ctx->Point.PointSprite ||
+				!gl_ctx->Point.CoordReplace[0] || (raster_texture_format(gl_ctx) < 0)) {
+			return NULL;
+		}
+		return depth ? sprite_z_point : sprite_point;
+	}
+
+	// Blending, fog, clipping and the like.
+	if (raster_mask) {
+		return NULL;
+	}
+
+	if (gl_ctx->Point._Size == 1.0F) {
+		return depth ? z_point : point;
+	} else {
+		return depth ? sized_z_point : sized_point;
+	}
+}
+
+/*
+ * swrast choose_point hook.
+ */
+void amesa_choose_point(GLcontext *gl_ctx) {
+	SWcontext *swrast = SWRAST_CONTEXT(gl_ctx);
+
+	if (!(swrast->Point = get_point_func(gl_ctx))) {
+		_swrast_choose_point(gl_ctx);
+	}
+}
@@ -0,0 +1,178 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * One pixel wide Bresenham line into a 32-bit draw buffer.  This file is
+ * included by amiga_mesa_line.c once per line function, with these
+ * defined:
+ *
+ *   NAME        - name of the line function
+ *   INTERP_Z    - define to depth test against the 16-bit depth buffer
+ *   INTERP_RGBA - define to interpolate the color, otherwise the line is
+ *                 drawn in the color of the second vertex
+ *
+ * Like swrast, the last pixel of the line is not drawn, so connected
+ * lines do not draw their shared vertices twice.
+ */
+
+static void NAME(GLcontext *gl_ctx, const SWvertex *v0, const SWvertex *v1) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	RASTER_SHIFTS(a_ctx);
+	GLint x0 = (GLint) v0->win[0];
+	GLint y0 = (GLint) v0->win[1];
+	GLint x1 = (GLint) v1->win[0];
+	GLint y1 = (GLint) v1->win[1];
+	GLint dx, dy, n, err, err_inc, err_dec;
+	GLint major_step, minor_step; /* In bytes */
+	GLuint *pixel;
+#ifdef INTERP_Z
+	RASTER_DEPTH_FUNC(a_ctx);
+	const GLint depth_width = gl_ctx->DrawBuffer->Width;
+	GLint z_major, z_minor;
+	GLfixed z, z_step;
+	GLushort *zp;
+#endif
+#ifdef INTERP_RGBA
+	GLfixed r, g, b, a, r_step, g_step, b_step, a_step;
+#else
+	const GLuint p = RASTER_PACK(v1->color[RCOMP], v1->color[GCOMP], v1->color[BCOMP], v1->color[ACOMP]);
+#endif
+
+	if (IS_INF_OR_NAN(v0->win[0] + v0->win[1] + v1->win[0] + v1->win[1])) {
+		return;
+	}
+
+	// Ends exactly on the right or top edge of the window are still
+	// inside the clip volume, pull them in.
+	if ((x0 == (GLint) a_ctx->width) || (x1 == (GLint) a_ctx->width)) {
+		if ((x0 == (GLint) a_ctx->width) && (x1 == (GLint) a_ctx->width)) {
+			return;
+		}
+		x0 -= (x0 == (GLint) a_ctx->width);
+		x1 -= (x1 == (GLint) a_ctx->width);
+	}
+	if ((y0 == (GLint) a_ctx->height) || (y1 == (GLint) a_ctx->height)) {
+		if ((y0 == (GLint) a_ctx->height) && (y1 == (GLint) a_ctx->height)) {
+			return;
+		}
+		y0 -= (y0 == (GLint) a_ctx->height);
+		y1 -= (y1 == (GLint) a_ctx->height);
+	}
+
+	dx = x1 - x0;
+	dy = y1 - y0;
+	if ((dx == 0) && (dy == 0)) {
+		return;
+	}
+
+	raster_begin(a_ctx, (GLfloat) MIN2(x0, x1), (GLfloat) MIN2(y0, y1), (GLfloat) MAX2(x0, x1), (GLfloat) MAX2(y0, y1));
+	if (a_ctx->tiles->count) {
+		amesa_display_touch_line(a_ctx, x0, a_ctx->height - y0 - 1, x1, a_ctx->height - y1 - 1);
+	}
+
+	// Rows go down the buffer as Y goes up.
+	pixel = (GLuint*) (a_ctx->draw_buffer + ((a_ctx->height - y0 - 1) * a_ctx->draw_pitch)) + x0;
+#ifdef INTERP_Z
+	zp = (GLushort*) _mesa_zbuffer_address(gl_ctx, x0, y0);
+#endif
+
+	if (ABSI(dx) >= ABSI(dy)) {
+		n = ABSI(dx);
+		major_step = (dx > 0) ? (GLint) sizeof(GLuint) : -(GLint) sizeof(GLuint);
+		minor_step = (dy > 0) ? -(GLint) a_ctx->draw_pitch : (GLint) a_ctx->draw_pitch;
+#ifdef INTERP_Z
+		z_major = (dx > 0) ? 1 : -1;
+		z_minor = (dy > 0) ? depth_width : -depth_width;
+#endif
+		err_inc = 2 * ABSI(dy);
+		err_dec = err_inc - (2 * n);
+		err = err_inc - n;
+	} else {
+		n = ABSI(dy);
+		major_step = (dy > 0) ? -(GLint) a_ctx->draw_pitch : (GLint) a_ctx->draw_pitch;
+		minor_step = (dx > 0) ? (GLint) sizeof(GLuint) : -(GLint) sizeof(GLuint);
+#ifdef INTERP_Z
+		z_major = (dy > 0) ? depth_width : -depth_width;
+		z_minor = (dx > 0) ? 1 : -1;
+#endif
+		err_inc = 2 * ABSI(dx);
+		err_dec = err_inc - (2 * n);
+		err = err_inc - n;
+	}
+
+#ifdef INTERP_Z
+	z = FloatToFixed(v0->win[2]) + FIXED_HALF;
+	z_step = (FloatToFixed(v1->win[2]) + FIXED_HALF - z) / n;
+#endif
+#ifdef INTERP_RGBA
+	r = ChanToFixed(v0->color[RCOMP]) + FIXED_HALF;
+	g = ChanToFixed(v0->color[GCOMP]) + FIXED_HALF;
+	b = ChanToFixed(v0->color[BCOMP]) + FIXED_HALF;
+	a = ChanToFixed(v0->color[ACOMP]) + FIXED_HALF;
+	r_step = (ChanToFixed(v1->color[RCOMP]) - ChanToFixed(v0->color[RCOMP])) / n;
+	g_step = (ChanToFixed(v1->color[GCOMP]) - ChanToFixed(v0->color[GCOMP])) / n;
+	b_step = (ChanToFixed(v1->color[BCOMP]) - ChanToFixed(v0->color[BCOMP])) / n;
+	a_step = (ChanToFixed(v1->color[ACOMP]) - ChanToFixed(v0->color[ACOMP])) / n;
+#endif
+
+	for (GLint i = 0; i < n; i++) {
+#ifdef INTERP_Z
+		const GLuint zi = (GLuint) FixedToInt(z);
+
+		if (RASTER_Z_PASS(zi, *zp)) {
+			*zp = (GLushort) zi;
+#else
+		{
+#endif
+#ifdef INTERP_RGBA
+			*pixel = RASTER_PACK(FixedToInt(r), FixedToInt(g), FixedToInt(b), FixedToInt(a));
+#else
+			*pixel = p;
+#endif
+		}
+
+		pixel = (GLuint*) ((GLubyte*) pixel + major_step);
+#ifdef INTERP_Z
+		zp += z_major;
+		z += z_step;
+#endif
+#ifdef INTERP_RGBA
+		r += r_step;
+		g += g_step;
+		b += b_step;
+		a += a_step;
+#endif
+
+		if (err < 0) {
+			err += err_inc;
+		} else {
+			pixel = (GLuint*) ((GLubyte*) pixel + minor_step);
+#ifdef INTERP_Z
+			zp += z_minor;
+#endif
+			err += err_dec;
+		}
+	}
+}
+
+#undef NAME
+#undef INTERP_Z
+#undef INTERP_RGBA
@@ -0,0 +1,175 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Square point into a 32-bit draw buffer.  This file is included by
+ * amiga_mesa_line.c once per point function, with these defined:
+ *
+ *   NAME     - name of the point function
+ *   INTERP_Z - define to depth test against the 16-bit depth buffer
+ *   SIZED    - define for points of ctx->Point._Size, otherwise they are
+ *              one pixel
+ *   SPRITE   - define to texture sized points with texture 0 across the
+ *              point (NV_point_sprite), requires SIZED
+ *
+ * Sized points cover the same pixels as swrast's, clipped to the window.
+ */
+
+static void NAME(GLcontext *gl_ctx, const SWvertex *v) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	RASTER_SHIFTS(a_ctx);
+#ifdef INTERP_Z
+	RASTER_DEPTH_FUNC(a_ctx);
+	const GLuint z = (GLuint) (v->win[2] + 0.5F);
+#endif
+#ifdef SPRITE
+	const struct gl_texture_object *obj = gl_ctx->Texture.Unit[0].Current2D;
+	const struct gl_texture_image *image = obj->Image[obj->BaseLevel];
+	const GLchan *texture = (const GLchan*) image->Data;
+	const GLint smask = image->Width - 1;
+	const GLint tmask = image->Height - 1;
+	const GLint wlog2 = image->WidthLog2;
+	const GLboolean rgba = (image->TexFormat->MesaFormat == MESA_FORMAT_RGBA);
+	const GLboolean modulate = (gl_ctx->Texture.Unit[0].EnvMode == GL_MODULATE);
+	GLint s0, ds, t, dt; /* 16.16 */
+#else
+	const GLuint p = RASTER_PACK(v->color[RCOMP], v->color[GCOMP], v->color[BCOMP], v->color[ACOMP]);
+#endif
+	GLint x1, y1, x2, y2;
+
+	if (IS_INF_OR_NAN(v->win[0] + v->win[1])) {
+		return;
+	}
+
+#ifdef SIZED
+	{
+		const GLfloat size = gl_ctx->Point._Size;
+		const GLint isize = MAX2(1, (GLint) (size + 0.5F));
+		const GLint radius = isize / 2;
+
+		if (isize & 1) {
+			x1 = (GLint) (v->win[0] - radius);
+			y1 = (GLint) (v->win[1] - radius);
+		} else {
+			x1 = (GLint) v->win[0] - radius + 1;
+			y1 = (GLint) v->win[1] - radius + 1;
+		}
+		x2 = x1 + isize - 1;
+		y2 = y1 + isize - 1;
+
+#ifdef SPRITE
+		if (!texture) {
+			return;
+		}
+
+		// Texel coordinates of the pixel centers, t = 0 at the top.  They
+		// are stepped in fixed point, which needs no FPU.
+		ds = (GLint) (image->Width * 65536.0F / size);
+		dt = (GLint) (image->Height * 65536.0F / size);
+		s0 = (GLint) ((0.5F + ((MAX2(x1, 0) + 0.5F - v->win[0]) / size)) * image->Width * 65536.0F);
+		t = (GLint) ((0.5F - ((MIN2(y2, (GLint) a_ctx->height - 1) + 0.5F - v->win[1]) / size)) * image->Height * 65536.0F);
+#endif
+	}
+
+	x1 = MAX2(x1, 0);
+	y1 = MAX2(y1, 0);
+	x2 = MIN2(x2, (GLint) a_ctx->width - 1);
+	y2 = MIN2(y2, (GLint) a_ctx->height - 1);
+	if ((x1 > x2) || (y1 > y2)) {
+		return;
+	}
+#else
+	x1 = x2 = (GLint) v->win[0];
+	y1 = y2 = (GLint) v->win[1];
+	if ((x1 >= (GLint) a_ctx->width) || (y1 >= (GLint) a_ctx->height)) {
+		return;
+	}
+#endif
+
+	raster_begin(a_ctx, (GLfloat) x1, (GLfloat) y1, (GLfloat) x2, (GLfloat) y2);
+	if (a_ctx->tiles->count) {
+		amesa_display_touch_tiles(a_ctx, x1, a_ctx->height - y2 - 1, x2 - x1 + 1, y2 - y1 + 1);
+	}
+
+#ifdef SIZED
+	// Top row down.
+	for (GLint y = y2; y >= y1; y--) {
+		GLuint *pixel = (GLuint*) (a_ctx->draw_buffer + ((a_ctx->height - y - 1) * a_ctx->draw_pitch));
+#ifdef INTERP_Z
+		GLushort *zp = (GLushort*) _mesa_zbuffer_address(gl_ctx, 0, y);
+#endif
+#ifdef SPRITE
+		const GLchan *row = texture + (((t >> 16) & tmask) << wlog2) * (rgba ? 4 : 3);
+		GLint s = s0;
+#endif
+
+		for (GLint x = x1; x <= x2; x++) {
+#ifdef INTERP_Z
+			if (RASTER_Z_PASS(z, zp[x])) {
+				zp[x] = (GLushort) z;
+#else
+			{
+#endif
+#ifdef SPRITE
+				const GLchan *texel = row + ((s >> 16) & smask) * (rgba ? 4 : 3);
+				const GLuint ta = rgba ? texel[3] : CHAN_MAX;
+
+				if (modulate) {
+					pixel[x] = RASTER_PACK((texel[0] * (v->color[RCOMP] + 1)) >> 8,
+							(texel[1] * (v->color[GCOMP] + 1)) >> 8,
+							(texel[2] * (v->color[BCOMP] + 1)) >> 8,
+							(ta * (v->color[ACOMP] + 1)) >> 8);
+				} else {
+					pixel[x] = RASTER_PACK(texel[0], texel[1], texel[2], rgba ? ta : v->color[ACOMP]);
+				}
+#else
+				pixel[x] = p;
+#endif
+			}
+#ifdef SPRITE
+			s += ds;
+#endif
+		}
+#ifdef SPRITE
+		t += dt;
+#endif
+	}
+#else
+	{
+		GLuint *pixel = (GLuint*) (a_ctx->draw_buffer + ((a_ctx->height - y1 - 1) * a_ctx->draw_pitch)) + x1;
+#ifdef INTERP_Z
+		GLushort *zp = (GLushort*) _mesa_zbuffer_address(gl_ctx, x1, y1);
+
+		if (RASTER_Z_PASS(z, *zp)) {
+			*zp = (GLushort) z;
+			*pixel = p;
+		}
+#else
+		*pixel = p;
+#endif
+	}
+#endif
+}
+
+#undef NAME
+#undef INTERP_Z
+#undef SIZED
+#undef SPRITE
@@ -0,0 +1,141 @@
+
+#ifndef AMIGA_MESA_RASTER_H
+#define AMIGA_MESA_RASTER_H
+
+/*
+ * Driver rasterizers that write straight into 32-bit buffers, installed
+ * from the swrast choose hooks.  They fall back to the swrast functions for
+ * any state they do not handle.
+ */
+
+/*
+ * Pack GLubyte components into a 32-bit pixel.  Expects the shifts of the
+ * context in rs, gs, bs and as.
+ */
+#define RASTER_PACK(r, g, b, a) \
+	(((GLuint) (r) << rs) | ((GLuint) (g) << gs) | ((GLuint) (b) << bs) | ((GLuint) (a) << as))
+
+#define RASTER_SHIFTS(a_ctx) \
+	const GLuint rs = (a_ctx)->shift[RCOMP]; \
+	const GLuint gs = (a_ctx)->shift[GCOMP]; \
+	const GLuint bs = (a_ctx)->shift[BCOMP]; \
+	const GLuint as = (a_ctx)->shift[ACOMP]
+
+/*
+ * Depth test of the context's depth function.  Mirroring both values turns
+ * GREATER/GEQUAL into LESS/LEQUAL, and LEQUAL is LESS against one more.
+ * Expects the setup of RASTER_DEPTH_FUNC in zxor and zbias.
+ */
+#define RASTER_Z_PASS(z, zbuf) (((GLuint) (z) ^ zxor) < (((GLuint) (zbuf) ^ zxor) + zbias))
+
+#define RASTER_DEPTH_FUNC(a_ctx) \
+	const GLuint zxor = (a_ctx)->z_xor; \
+	const GLuint zbias = (a_ctx)->z_bias
+
+/*
+ * Fill in the cleared tiles under a span (in window coordinates) before it
+ * is drawn.
+ */
+#define RASTER_TILES(a_ctx, x, y, n) \
+	if ((a_ctx)->tiles->count) amesa_display_touch_tiles(a_ctx, x, (a_ctx)->height - (y) - 1, n, 1)
+
+/*
+ * Set up the depth test for the rasterizers, FALSE if they cannot do it.
+ */
+static inline GLboolean raster_depth_setup(AMesaContext *a_ctx) {
+	GLcontext *gl_ctx = a_ctx->gl_ctx;
+
+	if ((gl_ctx->Visual.depthBits != DEFAULT_SOFTWARE_DEPTH_BITS) || !gl_ctx->Depth.Mask) {
+		return GL_FALSE;
+	}
+
+	switch (a_ctx->depth_test) {
+	case GL_LESS:
+		a_ctx->z_xor = 0;
+		a_ctx->z_bias = 0;
+		return GL_TRUE;
+	case GL_LEQUAL:
+		a_ctx->z_xor = 0;
+		a_ctx->z_bias = 1;
+		return GL_TRUE;
+	case GL_GREATER:
+		a_ctx->z_xor = 0xffff;
+		a_ctx->z_bias = 0;
+		return GL_TRUE;
+	case GL_GEQUAL:
+		a_ctx->z_xor = 0xffff;
+		a_ctx->z_bias = 1;
+		return GL_TRUE;
+	default:
+		return GL_FALSE;
+	}
+}
+
+/*
+ * The MESA_FORMAT_xxx of texture 0 if the textured rasterizers can apply
+ * it: 2D only, GL_REPEAT, GL_NEAREST, no border, an RGB or RGBA image with
+ * its texels loaded and GL_REPLACE or GL_MODULATE.  -1 if they cannot.
+ */
+static inline GLint raster_texture_format(GLcontext *gl_ctx) {
+	const struct gl_texture_unit *unit = &gl_ctx->Texture.Unit[0];
+	const struct gl_texture_object *obj = unit->Current2D;
+	const struct gl_texture_image *image;
+	GLint format;
+
+	if ((gl_ctx->Texture._EnabledUnits != 1) || (unit->_ReallyEnabled != TEXTURE_2D_BIT) ||
+			(gl_ctx->Light.Model.ColorControl != GL_SINGLE_COLOR) ||
+			((unit->EnvMode != GL_REPLACE) && (unit->EnvMode != GL_MODULATE))) {
+		return -1;
+	}
+
+	if ((obj->WrapS != GL_REPEAT) || (obj->WrapT != GL_REPEAT) ||
+			(obj->MinFilter != GL_NEAREST) || (obj->MagFilter != GL_NEAREST)) {
+		return -1;
+	}
+
+	image = obj->Image[obj->BaseLevel];
+	if (!image || !image->Data || (image->Border != 0)) {
+		return -1;
+	}
+
+	format = image->TexFormat->MesaFormat;
+	return ((format == MESA_FORMAT_RGB) || (format == MESA_FORMAT_RGBA)) ? format : -1;
+}
+
+/*
+ * Make sure there is something to draw into, and grow the dirty area over
+ * the pixels whose centers lie in the given window rectangle.
+ */
+static inline void raster_begin(AMesaContext *a_ctx, GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2) {
+	const GLint x = MAX2(IFLOOR(x1), 0);
+	const GLint right = MIN2(IFLOOR(x2) + 1, (GLint) a_ctx->width);
+	const GLint row = MAX2((GLint) a_ctx->height - 1 - IFLOOR(y2), 0);
+	const GLint bottom = MIN2((GLint) a_ctx->height - IFLOOR(y1), (GLint) a_ctx->height);
+
+	amesa_display_draw_rect(a_ctx, x, row, right - x, bottom - row);
+}
+
+/*
+ * Whether the rasterizers can draw with the current state at all.
+ */
+static inline GLboolean raster_usable(AMesaContext *a_ctx) {
+	return (a_ctx->pixel_bytes == 4) && (a_ctx->gl_ctx->RenderMode == GL_RENDER);
+}
+
+/*
+ * State the choice of triangle, line and point functions depends on,
+ * besides what swrast already watches.
+ */
+#define AMESA_NEW_TRIANGLE (_NEW_POLYGON | _NEW_DEPTH | _NEW_COLOR | _NEW_TEXTURE | \
+		_NEW_LIGHT | _NEW_HINT | _SWRAST_NEW_RASTERMASK)
+
+#define AMESA_NEW_LINE (_NEW_LINE | _NEW_DEPTH | _NEW_COLOR | _NEW_TEXTURE | \
+		_NEW_LIGHT | _SWRAST_NEW_RASTERMASK)
+#define AMESA_NEW_POINT (_NEW_POINT | _NEW_DEPTH | _NEW_COLOR | _NEW_TEXTURE | \
+		_NEW_LIGHT | _SWRAST_NEW_RASTERMASK)
+
+extern void amesa_choose_triangle(GLcontext *gl_ctx);
+extern void amesa_choose_line(GLcontext *gl_ctx);
+extern void amesa_choose_point(GLcontext *gl_ctx);
+
+#endif
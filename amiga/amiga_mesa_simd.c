@@ -0,0 +1,284 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * SSE2 and AVX2 span conversion and fill kernels.  Each kernel is compiled
+ * for its own instruction set, so the driver as a whole still runs on any
+ * x86 CPU and only calls what amesa_simd_init() found.
+ */
+
+#include <GL/gl.h>
+#include "amiga_mesa_simd.h"
+
+#include "glheader.h"
+#include "mtypes.h"
+
+#ifdef AMESA_SIMD
+
+#include <immintrin.h>
+
+struct amesa_simd amesa_simd = { "scalar" };
+
+#define PACK(r, g, b, a, shift) \
+	(((GLuint) (r) << shift[RCOMP]) | ((GLuint) (g) << shift[GCOMP]) | \
+	 ((GLuint) (b) << shift[BCOMP]) | ((GLuint) (a) << shift[ACOMP]))
+
+static inline void unpack(GLubyte rgba[4], GLuint p, const GLubyte shift[4]) {
+	rgba[RCOMP] = (GLubyte) (p >> shift[RCOMP]);
+	rgba[GCOMP] = (GLubyte) (p >> shift[GCOMP]);
+	rgba[BCOMP] = (GLubyte) (p >> shift[BCOMP]);
+	rgba[ACOMP] = (GLubyte) (p >> shift[ACOMP]);
+}
+
+/*
+ * SSE2, 4 pixels at a time.  The components are moved with shifts, as
+ * SSE2 cannot shuffle bytes.
+ */
+__attribute__((target("sse2")))
+static void pack_rgba_sse2(GLuint *dst, const GLubyte rgba[][4], GLuint n, const GLubyte shift[4]) {
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i rs = _mm_cvtsi32_si128(shift[RCOMP]);
+	const __m128i gs = _mm_cvtsi32_si128(shift[GCOMP]);
+	const __m128i bs = _mm_cvtsi32_si128(shift[BCOMP]);
+	const __m128i as = _mm_cvtsi32_si128(shift[ACOMP]);
+	GLuint i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*) rgba[i]);
+		const __m128i r = _mm_sll_epi32(_mm_and_si128(p, mask), rs);
+		const __m128i g = _mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(p, 8), mask), gs);
+		const __m128i b = _mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(p, 16), mask), bs);
+		const __m128i a = _mm_sll_epi32(_mm_srli_epi32(p, 24), as);
+
+		_mm_storeu_si128((__m128i*) &dst[i], _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a)));
+	}
+
+	for (; i < n; i++) {
+		dst[i] = PACK(rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], rgba[i][ACOMP], shift);
+	}
+}
+
+__attribute__((target("sse2")))
+static void unpack_rgba_sse2(GLubyte rgba[][4], const GLuint *src, GLuint n, const GLubyte shift[4]) {
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i rs = _mm_cvtsi32_si128(shift[RCOMP]);
+	const __m128i gs = _mm_cvtsi32_si128(shift[GCOMP]);
+	const __m128i bs = _mm_cvtsi32_si128(shift[BCOMP]);
+	const __m128i as = _mm_cvtsi32_si128(shift[ACOMP]);
+	GLuint i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*) &src[i]);
+		const __m128i r = _mm_and_si128(_mm_srl_epi32(p, rs), mask);
+		const __m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(p, gs), mask), 8);
+		const __m128i b = _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(p, bs), mask), 16);
+		const __m128i a = _mm_slli_epi32(_mm_srl_epi32(p, as), 24);
+
+		_mm_storeu_si128((__m128i*) rgba[i], _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a)));
+	}
+
+	for (; i < n; i++) {
+		unpack(rgba[i], src[i], shift);
+	}
+}
+
+/*
+ * The fills store whole vectors from the first aligned address on, and
+ * longwords and a 16-bit pixel around them like amesa_fill().
+ */
+#define FILL_HEAD(dst, bytes, value, align) \
+	if ((((unsigned long) dst) & 2) && (bytes >= 2)) { \
+		*(GLushort*) dst = (GLushort) value; \
+		dst += 2; \
+		bytes -= 2; \
+	} \
+	while ((((unsigned long) dst) & ((align) - 1)) && (bytes >= 4)) { \
+		*(GLuint*) dst = value; \
+		dst += 4; \
+		bytes -= 4; \
+	}
+
+#define FILL_TAIL(dst, bytes, value) \
+	for (; bytes >= 4; bytes -= 4) { \
+		*(GLuint*) dst = value; \
+		dst += 4; \
+	} \
+	if (bytes >= 2) { \
+		*(GLushort*) dst = (GLushort) value; \
+	}
+
+__attribute__((target("sse2")))
+static void fill_sse2(GLubyte *dst, GLuint bytes, GLuint value) {
+	const __m128i v = _mm_set1_epi32(value);
+
+	FILL_HEAD(dst, bytes, value, 16);
+
+	for (; bytes >= 64; bytes -= 64) {
+		_mm_store_si128((__m128i*) dst, v);
+		_mm_store_si128((__m128i*) (dst + 16), v);
+		_mm_store_si128((__m128i*) (dst + 32), v);
+		_mm_store_si128((__m128i*) (dst + 48), v);
+		dst += 64;
+	}
+	for (; bytes >= 16; bytes -= 16) {
+		_mm_store_si128((__m128i*) dst, v);
+		dst += 16;
+	}
+
+	FILL_TAIL(dst, bytes, value);
+}
+
+/*
+ * AVX2, 8 pixels at a time.  The components are shuffled into place with
+ * a byte shuffle built from the shifts: byte k of a pixel is the component
+ * shifted by 8k.
+ */
+__attribute__((target("avx2")))
+static __m256i pack_shuffle(const GLubyte shift[4]) {
+	GLubyte bytes[32];
+
+	for (GLuint i = 0; i < 32; i += 4) {
+		for (GLuint c = 0; c < 4; c++) {
+			bytes[i + (shift[c] >> 3)] = i + c;
+		}
+	}
+	return _mm256_loadu_si256((const __m256i*) bytes);
+}
+
+__attribute__((target("avx2")))
+static __m256i unpack_shuffle(const GLubyte shift[4]) {
+	GLubyte bytes[32];
+
+	for (GLuint i = 0; i < 32; i += 4) {
+		for (GLuint c = 0; c < 4; c++) {
+			bytes[i + c] = i + (shift[c] >> 3);
+		}
+	}
+	return _mm256_loadu_si256((const __m256i*) bytes);
+}
+
+__attribute__((target("avx2")))
+static void pack_rgba_avx2(GLuint *dst, const GLubyte rgba[][4], GLuint n, const GLubyte shift[4]) {
+	const __m256i shuffle = pack_shuffle(shift);
+	GLuint i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		const __m256i p = _mm256_loadu_si256((const __m256i*) rgba[i]);
+
+		_mm256_storeu_si256((__m256i*) &dst[i], _mm256_shuffle_epi8(p, shuffle));
+	}
+
+	for (; i < n; i++) {
+		dst[i] = PACK(rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], rgba[i][ACOMP], shift);
+	}
+}
+
+/*
+ * RGB is 3 bytes a pixel, so it goes 4 pixels from a 16 byte load.  The
+ * 4 bytes past them are read too, which stays inside the span while 2
+ * more pixels follow.
+ */
+__attribute__((target("avx2")))
+static void pack_rgb_avx2(GLuint *dst, const GLubyte rgb[][3], GLuint n, const GLubyte shift[4]) {
+	const __m128i alpha = _mm_set1_epi32(0xffu << shift[ACOMP]);
+	GLubyte bytes[16];
+	__m128i shuffle;
+	GLuint i = 0;
+
+	for (GLuint j = 0; j < 4; j++) {
+		for (GLuint c = 0; c < 4; c++) {
+			bytes[(j * 4) + (shift[c] >> 3)] = (c == ACOMP) ? 0x80 : (j * 3) + c;
+		}
+	}
+	shuffle = _mm_loadu_si128((const __m128i*) bytes);
+
+	for (; i + 6 <= n; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*) rgb[i]);
+
+		_mm_storeu_si128((__m128i*) &dst[i], _mm_or_si128(_mm_shuffle_epi8(p, shuffle), alpha));
+	}
+
+	for (; i < n; i++) {
+		dst[i] = PACK(rgb[i][RCOMP], rgb[i][GCOMP], rgb[i][BCOMP], 0xff, shift);
+	}
+}
+
+__attribute__((target("avx2")))
+static void unpack_rgba_avx2(GLubyte rgba[][4], const GLuint *src, GLuint n, const GLubyte shift[4]) {
+	const __m256i shuffle = unpack_shuffle(shift);
+	GLuint i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		const __m256i p = _mm256_loadu_si256((const __m256i*) &src[i]);
+
+		_mm256_storeu_si256((__m256i*) rgba[i], _mm256_shuffle_epi8(p, shuffle));
+	}
+
+	for (; i < n; i++) {
+		unpack(rgba[i], src[i], shift);
+	}
+}
+
+__attribute__((target("avx2")))
+static void fill_avx2(GLubyte *dst, GLuint bytes, GLuint value) {
+	const __m256i v = _mm256_set1_epi32(value);
+
+	FILL_HEAD(dst, bytes, value, 32);
+
+	for (; bytes >= 128; bytes -= 128) {
+		_mm256_store_si256((__m256i*) dst, v);
+		_mm256_store_si256((__m256i*) (dst + 32), v);
+		_mm256_store_si256((__m256i*) (dst + 64), v);
+		_mm256_store_si256((__m256i*) (dst + 96), v);
+		dst += 128;
+	}
+	for (; bytes >= 32; bytes -= 32) {
+		_mm256_store_si256((__m256i*) dst, v);
+		dst += 32;
+	}
+
+	FILL_TAIL(dst, bytes, value);
+}
+
+void amesa_simd_init(GLboolean enable) {
+	static const struct amesa_simd scalar = { "scalar" };
+	static const struct amesa_simd sse2 = {
+		"SSE2", pack_rgba_sse2, NULL, unpack_rgba_sse2, fill_sse2
+	};
+	static const struct amesa_simd avx2 = {
+		"AVX2", pack_rgba_avx2, pack_rgb_avx2, unpack_rgba_avx2, fill_avx2
+	};
+
+	amesa_simd = scalar;
+	if (!enable) {
+		return;
+	}
+
+	// Also checks that the OS saves the AVX registers.
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		amesa_simd = avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		amesa_simd = sse2;
+	}
+}
+
+#endif
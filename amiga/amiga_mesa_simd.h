@@ -0,0 +1,39 @@
+#ifndef AMIGA_MESA_SIMD_H
+#define AMIGA_MESA_SIMD_H
+
+/*
+ * Vector kernels for the hosted x86 targets (AROS x86-64 and the like),
+ * picked at run time from what the CPU supports.  The scalar span
+ * functions and fill stay the reference, a NULL kernel means they are
+ * used.  Other vector units (AltiVec on PowerPC) would fill in the same
+ * table.
+ *
+ * Pixels are 32-bit with components at the bit positions in shift[], as
+ * in the context.  Only built where AMESA_SIMD gets defined.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AMESA_SIMD
+#endif
+
+#ifdef AMESA_SIMD
+
+struct amesa_simd {
+	const char *name; /* Instruction set of the kernels, "scalar" for none */
+	void (*pack_rgba)(GLuint *dst, const GLubyte rgba[][4], GLuint n, const GLubyte shift[4]);
+	void (*pack_rgb)(GLuint *dst, const GLubyte rgb[][3], GLuint n, const GLubyte shift[4]);
+	void (*unpack_rgba)(GLubyte rgba[][4], const GLuint *src, GLuint n, const GLubyte shift[4]);
+	void (*fill)(GLubyte *dst, GLuint bytes, GLuint value); /* As amesa_fill() */
+};
+
+extern struct amesa_simd amesa_simd;
+
+/*
+ * Pick the best kernels the CPU can run, or go back to the scalar code
+ * when enable is FALSE.
+ */
+extern void amesa_simd_init(GLboolean enable);
+
+#endif
+
+#endif
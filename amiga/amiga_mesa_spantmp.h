@@ -0,0 +1,300 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Span and pixel functions for one pixel layout.  This file is included
+ * by amiga_mesa_display.c once per layout, with these defined:
+ *
+ *   NAME(func)                   - name of func for this layout
+ *   PIXEL_TYPE                   - GLuint or GLushort
+ *   PACK_PIXEL(x, y, r, g, b, a) - pack GLubyte components into a pixel
+ *                                  at window position x, y
+ *   UNPACK_PIXEL(p, rgba)        - unpack pixel p into GLubyte rgba[4]
+ *   DITHER                       - define if PACK_PIXEL depends on the
+ *                                  position, optional
+ *   SIMD_PIXELS                  - define for 32-bit layouts to convert
+ *                                  with the amesa_simd kernels where there
+ *                                  are any, optional
+ *
+ * NAME(init_span_funcs)() installs the generated functions.  Pixels are
+ * found with DRAW_ADDRESS, so all layouts share the row addressing of the
+ * draw buffer.  Masked spans are written a run of set pixels at a time,
+ * found with mask_run().
+ */
+
+// Vector kernels only exist on some CPUs.
+#ifndef AMESA_SIMD
+#undef SIMD_PIXELS
+#endif
+
+#ifdef DITHER
+#define MONO_PIXEL(x, y) PACK_PIXEL(x, y, color[RCOMP], color[GCOMP], color[BCOMP], color[ACOMP])
+#else
+#define MONO_PIXEL(x, y) hicolor
+#endif
+
+/* Write a horizontal span of RGB color pixels with a boolean mask. */
+static void NAME(write_rgb_span)(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
+                           const GLubyte rgba[][3], const GLubyte mask[]) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+    // Calculate the start of the row in the buffer
+    DRAW_BEGIN(a_ctx);
+    PIXEL_TYPE *buffer = DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x, y);
+
+    STATS_SPAN(a_ctx, AMESA_HOOK_WRITE_RGB_SPAN, n, mask);
+    dirty_rect(a_ctx, x, a_ctx->height - y - 1, n, 1);
+    TILES_SPAN(a_ctx, x, a_ctx->height - y - 1, n);
+
+    if (mask) {
+        GLuint i = 0, end;
+
+        // Each run of set pixels like an unmasked span
+        while ((end = mask_run(mask, n, &i))) {
+#ifdef SIMD_PIXELS
+            if (amesa_simd.pack_rgb) {
+                amesa_simd.pack_rgb(buffer + i, rgba + i, end - i, a_ctx->shift);
+                i = end;
+                continue;
+            }
+#endif
+            for (; i < end; i++) {
+                // Convert 3-component RGB to a pixel (Alpha set to 255/Opaque)
+                buffer[i] = PACK_PIXEL(x + i, y, rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], 255);
+            }
+        }
+    } else {
+#ifdef SIMD_PIXELS
+        if (amesa_simd.pack_rgb) {
+            amesa_simd.pack_rgb(buffer, rgba, n, a_ctx->shift);
+            return;
+        }
+#endif
+        // FAST PATH: No mask, direct writes
+        for (GLuint i = 0; i < n; i++) {
+            buffer[i] = PACK_PIXEL(x + i, y, rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], 255);
+        }
+    }
+}
+
+/* Write a horizontal span of RGBA color pixels with a boolean mask. */
+static void NAME(write_rgba_span)(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
+                           const GLubyte rgba[][4], const GLubyte mask[]) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+	// Simple pointer math: (row offset) + x
+	DRAW_BEGIN(a_ctx);
+	PIXEL_TYPE *buffer = DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x, y);
+
+	STATS_SPAN(a_ctx, AMESA_HOOK_WRITE_RGBA_SPAN, n, mask);
+	dirty_rect(a_ctx, x, a_ctx->height - y - 1, n, 1);
+	TILES_SPAN(a_ctx, x, a_ctx->height - y - 1, n);
+
+	if (mask) {
+		GLuint i = 0, end;
+
+		while ((end = mask_run(mask, n, &i))) {
+#ifdef SIMD_PIXELS
+			if (amesa_simd.pack_rgba) {
+				amesa_simd.pack_rgba(buffer + i, rgba + i, end - i, a_ctx->shift);
+				i = end;
+				continue;
+			}
+#endif
+			for (; i < end; i++) {
+				buffer[i] = PACK_PIXEL(x + i, y, rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], rgba[i][ACOMP]);
+			}
+		}
+	} else {
+#ifdef SIMD_PIXELS
+		if (amesa_simd.pack_rgba) {
+			amesa_simd.pack_rgba(buffer, rgba, n, a_ctx->shift);
+			return;
+		}
+#endif
+		for (GLuint i = 0; i < n; i++) {
+			buffer[i] = PACK_PIXEL(x + i, y, rgba[i][RCOMP], rgba[i][GCOMP], rgba[i][BCOMP], rgba[i][ACOMP]);
+		}
+	}
+}
+
+/*
+ * Write a horizontal span of pixels with a boolean mask.  The current color
+ * is used for all pixels.
+ */
+static void NAME(write_mono_rgba_span)(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y,
+                                const GLchan color[4], const GLubyte mask[]) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+#ifndef DITHER
+    const PIXEL_TYPE hicolor = PACK_PIXEL(x, y, color[RCOMP], color[GCOMP], color[BCOMP], color[ACOMP]);
+#endif
+	DRAW_BEGIN(a_ctx);
+	PIXEL_TYPE *buffer = DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x, y);
+
+	STATS_SPAN(a_ctx, AMESA_HOOK_WRITE_MONO_RGBA_SPAN, n, mask);
+	dirty_rect(a_ctx, x, a_ctx->height - y - 1, n, 1);
+	TILES_SPAN(a_ctx, x, a_ctx->height - y - 1, n);
+
+	if (mask) {
+		GLuint i = 0, end;
+
+		while ((end = mask_run(mask, n, &i))) {
+			for (; i < end; i++) {
+				buffer[i] = MONO_PIXEL(x + i, y);
+			}
+		}
+	} else {
+		// Fast path for unmasked mono spans
+		for (GLuint i = 0; i < n; i++) {
+			buffer[i] = MONO_PIXEL(x + i, y);
+		}
+	}
+}
+
+/* Write an array of RGBA pixels with a boolean mask. */
+static void NAME(write_rgba_pixels)(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[],
+                             const GLubyte rgba[][4], const GLubyte mask[]) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+    DRAW_BEGIN(a_ctx);
+    int h = a_ctx->height - 1;
+
+    STATS_PIXELS(a_ctx, AMESA_HOOK_WRITE_RGBA_PIXELS, n, mask);
+    TILES_PIXELS(a_ctx, n, x, y, mask);
+
+    GLint xmin = a_ctx->width, xmax = -1, ymin = h, ymax = -1;
+
+    for (GLuint i = 0; i < n; i++) {
+        if (mask[i]) {
+            *DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x[i], y[i]) = PACK_PIXEL(x[i], y[i], rgba[i][0], rgba[i][1], rgba[i][2], rgba[i][3]);
+
+            if (x[i] < xmin) xmin = x[i];
+            if (x[i] > xmax) xmax = x[i];
+            if (y[i] < ymin) ymin = y[i];
+            if (y[i] > ymax) ymax = y[i];
+        }
+    }
+
+    if (xmax >= xmin) {
+        dirty_rect(a_ctx, xmin, h - ymax, xmax - xmin + 1, ymax - ymin + 1);
+    }
+}
+
+/*
+ * Write an array of pixels with a boolean mask.  The current color
+ * is used for all pixels.
+ */
+static void NAME(write_mono_rgba_pixels)(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[], const GLchan color[4],
+		const GLubyte mask[]) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+	DRAW_BEGIN(a_ctx);
+
+#ifndef DITHER
+	// Convert the single mono color to a pixel
+	const PIXEL_TYPE hicolor = PACK_PIXEL(0, 0, color[RCOMP], color[GCOMP], color[BCOMP], color[ACOMP]);
+#endif
+
+	int h = a_ctx->height - 1;
+
+	STATS_PIXELS(a_ctx, AMESA_HOOK_WRITE_MONO_RGBA_PIXELS, n, mask);
+	TILES_PIXELS(a_ctx, n, x, y, mask);
+
+	GLint xmin = a_ctx->width, xmax = -1, ymin = h, ymax = -1;
+
+	for (GLuint i = 0; i < n; i++) {
+		if (mask[i]) {
+			*DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x[i], y[i]) = MONO_PIXEL(x[i], y[i]);
+
+			if (x[i] < xmin) xmin = x[i];
+			if (x[i] > xmax) xmax = x[i];
+			if (y[i] < ymin) ymin = y[i];
+			if (y[i] > ymax) ymax = y[i];
+		}
+	}
+
+	if (xmax >= xmin) {
+		dirty_rect(a_ctx, xmin, h - ymax, xmax - xmin + 1, ymax - ymin + 1);
+	}
+}
+
+/* Read a horizontal span of color pixels. */
+static void NAME(read_rgba_span)(const GLcontext *gl_ctx, GLuint n, GLint x, GLint y, GLubyte rgba[][4]) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+    // Use pixel sized pointers so the CPU fetches whole pixels
+    DRAW_BEGIN(a_ctx);
+    PIXEL_TYPE *src = DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x, y);
+
+    STATS_READ(a_ctx, AMESA_HOOK_READ_RGBA_SPAN);
+    TILES_SPAN(a_ctx, x, a_ctx->height - y - 1, n);
+
+#ifdef SIMD_PIXELS
+    if (amesa_simd.unpack_rgba) {
+        amesa_simd.unpack_rgba(rgba, src, n, a_ctx->shift);
+        return;
+    }
+#endif
+    for (GLuint i = 0; i < n; i++) {
+        PIXEL_TYPE pixel = src[i]; // Fetch the whole pixel at once
+
+        UNPACK_PIXEL(pixel, rgba[i]);
+    }
+}
+
+/* Read an array of color pixels. */
+static void NAME(read_rgba_pixels)(const GLcontext *gl_ctx, GLuint n, const GLint x[], const GLint y[], GLubyte rgba[][4],
+        const GLubyte mask[]) {
+    AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+
+    DRAW_BEGIN(a_ctx);
+
+    STATS_READ(a_ctx, AMESA_HOOK_READ_RGBA_PIXELS);
+    TILES_PIXELS(a_ctx, n, x, y, mask);
+
+    for (GLuint i = 0; i < n; i++) {
+        if (mask[i]) {
+            PIXEL_TYPE color = *DRAW_ADDRESS(a_ctx, PIXEL_TYPE, x[i], y[i]);
+
+            UNPACK_PIXEL(color, rgba[i]);
+        }
+    }
+}
+
+static void NAME(init_span_funcs)(struct swrast_device_driver *swdd) {
+	swdd->WriteRGBSpan = NAME(write_rgb_span);
+	swdd->WriteRGBASpan = NAME(write_rgba_span);
+	swdd->WriteRGBAPixels = NAME(write_rgba_pixels);
+
+	swdd->WriteMonoRGBASpan = NAME(write_mono_rgba_span);
+	swdd->WriteMonoRGBAPixels = NAME(write_mono_rgba_pixels);
+
+	swdd->ReadRGBASpan = NAME(read_rgba_span);
+	swdd->ReadRGBAPixels = NAME(read_rgba_pixels);
+}
+
+#undef NAME
+#undef PIXEL_TYPE
+#undef PACK_PIXEL
+#undef UNPACK_PIXEL
+#undef MONO_PIXEL
+#undef DITHER
+#undef SIMD_PIXELS
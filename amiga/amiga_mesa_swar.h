@@ -0,0 +1,41 @@
+
+#ifndef AMIGA_MESA_SWAR_H
+#define AMIGA_MESA_SWAR_H
+
+/*
+ * Arithmetic on all four 8-bit components of a 32-bit pixel at once, in
+ * plain integer registers.  Multiplies work on two components at a time,
+ * spread out to 16 bits each with SWAR_MASK, so a pixel takes two of them
+ * instead of four.  None of this depends on the component order.
+ *
+ * Factors t are 0 to 256, which is 0.0 to 1.0.  A GLubyte a becomes one
+ * with a + (a >> 7).
+ */
+
+#define SWAR_MASK 0x00ff00ff
+
+/*
+ * Every component moved from d towards s by t, rounded.  t = 0 gives d and
+ * t = 256 gives s.  The differences may borrow from the next component up,
+ * that drops out again with the mask.
+ */
+static inline GLuint swar_lerp(GLuint d, GLuint s, GLuint t) {
+	const GLuint rb = d & SWAR_MASK;
+	const GLuint ag = (d >> 8) & SWAR_MASK;
+
+	return ((rb + (((((s & SWAR_MASK) - rb) * t) + 0x00800080) >> 8)) & SWAR_MASK) |
+			(((ag << 8) + ((((s >> 8) & SWAR_MASK) - ag) * t) + 0x00800080) & ~SWAR_MASK);
+}
+
+/*
+ * The sum of every component of a and b, saturated at 255.
+ */
+static inline GLuint swar_add_sat(GLuint a, GLuint b) {
+	const GLuint sum = (a & 0x7f7f7f7f) + (b & 0x7f7f7f7f);
+	const GLuint carry = ((a & b) | ((a | b) & sum)) & 0x80808080;
+
+	// Components that carried out become 255.
+	return sum | ((a | b) & 0x80808080) | ((carry << 1) - (carry >> 7));
+}
+
+#endif
@@ -0,0 +1,66 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <GL/gl.h>
+#include "amiga_mesa_timer.h"
+
+#include <devices/timer.h>
+#include <proto/timer.h>
+
+struct Device *TimerBase = NULL;
+
+static struct timerequest timer_request;
+static GLuint timer_open_count = 0;
+static GLdouble timer_seconds_per_tick = 0.0;
+
+GLboolean amesa_timer_open(void) {
+	if (timer_open_count == 0) {
+		struct EClockVal eclock;
+
+		// The request is only used to get at the device base, no I/O is
+		// ever sent to it.
+		if (OpenDevice(TIMERNAME, UNIT_ECLOCK, (struct IORequest*) &timer_request, 0) != 0) {
+			return GL_FALSE;
+		}
+
+		TimerBase = timer_request.tr_node.io_Device;
+		timer_seconds_per_tick = 1.0 / (GLdouble) ReadEClock(&eclock);
+	}
+
+	timer_open_count++;
+	return GL_TRUE;
+}
+
+void amesa_timer_close(void) {
+	if (timer_open_count > 0) {
+		if (--timer_open_count == 0) {
+			CloseDevice((struct IORequest*) &timer_request);
+			TimerBase = NULL;
+		}
+	}
+}
+
+GLdouble amesa_timer_now(void) {
+	struct EClockVal eclock;
+
+	ReadEClock(&eclock);
+	return ((GLdouble) eclock.ev_hi * 4294967296.0 + (GLdouble) eclock.ev_lo) * timer_seconds_per_tick;
+}
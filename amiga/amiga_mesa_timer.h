@@ -0,0 +1,19 @@
+
+#ifndef AMIGA_MESA_TIMER_H
+#define AMIGA_MESA_TIMER_H
+
+/*
+ * E-clock based timing for the benchmark and profiling code.
+ *
+ * amesa_timer_open() and amesa_timer_close() are reference counted, every
+ * successful open must be matched by a close.
+ */
+extern GLboolean amesa_timer_open(void);
+extern void amesa_timer_close(void);
+
+/*
+ * Current time in seconds, from an arbitrary origin.
+ */
+extern GLdouble amesa_timer_now(void);
+
+#endif
@@ -0,0 +1,840 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Triangle rasterizers that write 32-bit pixels straight into the draw
+ * buffer, generated from swrast's triangle template like XMesa's.  A
+ * second set is generated from amiga_mesa_fxtritmp.h, which does not need
+ * an FPU, for contexts rasterizing in fixed point.
+ */
+
+#include <string.h>
+
+#include <GL/amiga_mesa.h>
+#include "amiga_mesa_def.h"
+#include "amiga_mesa_display.h"
+#include "amiga_mesa_fill.h"
+#include "amiga_mesa_raster.h"
+
+#include "glheader.h"
+#include "macros.h"
+#include "texformat.h"
+#include "swrast/s_context.h"
+#include "swrast/s_depth.h"
+#include "swrast/s_triangle.h"
+
+/*
+ * The template addresses pixels with Y going up.
+ */
+#define TRI_PIXEL_ADDRESS(X, Y) \
+	((GLuint*) (a_ctx->draw_buffer + ((a_ctx->height - (Y) - 1) * a_ctx->draw_pitch)) + (X))
+
+/*
+ * Modulate two GLubyte components, like swrast does.
+ */
+#define TRI_PROD(a, b) (((GLuint) (a) * ((GLuint) (b) + 1)) >> 8)
+
+/*
+ * Lock the buffer and grow the dirty area over a triangle.
+ */
+static void tri_begin(AMesaContext *a_ctx, const SWvertex *v0, const SWvertex *v1, const SWvertex *v2) {
+	raster_begin(a_ctx,
+			MIN2(v0->win[0], MIN2(v1->win[0], v2->win[0])),
+			MIN2(v0->win[1], MIN2(v1->win[1], v2->win[1])),
+			MAX2(v0->win[0], MAX2(v1->win[0], v2->win[0])),
+			MAX2(v0->win[1], MAX2(v1->win[1], v2->win[1])));
+}
+
+#define TRI_SETUP \
+	AMesaContext *a_ctx = (AMesaContext*) ctx->DriverCtx; \
+	RASTER_SHIFTS(a_ctx); \
+	tri_begin(a_ctx, v0, v1, v2);
+
+/*
+ * Texture 0 for the textured triangles: 2D, power of two, GL_REPEAT and
+ * GL_NEAREST.  The floating-point triangles scale the texture coordinates
+ * by the size of the texture, the fixed-point ones by its log2.
+ */
+#define TRI_TEX_SETUP \
+	const struct gl_texture_object *obj = ctx->Texture.Unit[0].Current2D; \
+	const struct gl_texture_image *image = obj->Image[obj->BaseLevel]; \
+	const GLchan *texture = (const GLchan*) image->Data; \
+	const GLint smask = image->Width - 1; \
+	const GLint tmask = image->Height - 1; \
+	const GLint wlog2 = image->WidthLog2; \
+	const GLuint sub_shift = a_ctx->subdiv_shift; \
+	const GLuint sub_mask = (1 << sub_shift) - 1;
+
+#define TRI_TEX_SETUP_FLOAT \
+	TRI_TEX_SETUP \
+	const GLfloat twidth = (GLfloat) image->Width; \
+	const GLfloat theight = (GLfloat) image->Height;
+
+#define TRI_FX_TEX_SETUP \
+	TRI_TEX_SETUP \
+	const GLint hlog2 = image->HeightLog2;
+
+/*
+ * Perspective correct texture coordinates, in texels, along a span.
+ */
+#define TRI_TEX_SPAN(span) \
+	GLfloat s = span.tex[0][0] * twidth; \
+	GLfloat t = span.tex[0][1] * theight; \
+	GLfloat q = span.tex[0][3]; \
+	const GLfloat ds = span.texStepX[0][0] * twidth; \
+	const GLfloat dt = span.texStepX[0][1] * theight; \
+	const GLfloat dq = span.texStepX[0][3]
+
+#define TRI_TEX_FETCH(texel, bytes) { \
+	const GLfloat w = (q == 0.0F) ? 1.0F : (1.0F / q); \
+	texel = texture + ((((IFLOOR(t * w) & tmask) << wlog2) + (IFLOOR(s * w) & smask)) * (bytes)); \
+}
+
+#define TRI_TEX_STEP() s += ds; t += dt; q += dq
+
+/*
+ * Texel coordinates at the current s, t and q as GLfixed, and a step of
+ * n pixels, for subdivided spans.
+ */
+#define TRI_TEX_EXACT(si, ti) { \
+	const GLfloat w = (q == 0.0F) ? 1.0F : (1.0F / q); \
+	si = FloatToFixed(s * w); \
+	ti = FloatToFixed(t * w); \
+}
+
+#define TRI_TEX_ADVANCE(n) s += ds * (n); t += dt * (n); q += dq * (n)
+
+/*
+ * The same for the fixed-point triangles, which interpolate s * q, t * q
+ * and q as integers biased to stay positive.  They are always subdivided,
+ * so there are no divides per pixel.
+ */
+#define TRI_FX_TEX_SPAN(span) \
+	GLint s = span.s; \
+	GLint t = span.t; \
+	GLint q = span.q; \
+	const GLint ds = span.sStep; \
+	const GLint dt = span.tStep; \
+	const GLint dq = span.qStep
+
+#define TRI_FX_TEX_EXACT(si, ti) { \
+	const long long d = (q > 0) ? q : 1; \
+	si = (GLfixed) (((long long) s << FIXED_SHIFT) / d); \
+	ti = (GLfixed) (((long long) t << FIXED_SHIFT) / d); \
+}
+
+#define TRI_FX_TEX_ADVANCE(n) s += ds * (n); t += dt * (n); q += dq * (n)
+
+/*
+ * Subdivided spans do the perspective divide every 1 << sub_shift pixels
+ * only, and step the texel coordinates linearly in between.
+ */
+#define TRI_SUB_SPAN(tex) \
+	GLfixed si = 0, ti = 0, si_next, ti_next, dsi = 0, dti = 0; \
+	tex##_EXACT(si_next, ti_next)
+
+#define TRI_SUB_CHUNK(tex, i) \
+	if (((i) & sub_mask) == 0) { \
+		const GLint n = (GLint) MIN2(span.end - (i), sub_mask + 1); \
+		si = si_next; \
+		ti = ti_next; \
+		tex##_ADVANCE(n); \
+		tex##_EXACT(si_next, ti_next); \
+		if (n == (GLint) sub_mask + 1) { \
+			dsi = (si_next - si) >> sub_shift; \
+			dti = (ti_next - ti) >> sub_shift; \
+		} else { \
+			dsi = (si_next - si) / n; \
+			dti = (ti_next - ti) / n; \
+		} \
+	}
+
+#define TRI_SUB_FETCH(texel, bytes) \
+	texel = texture + ((((FixedToInt(ti) & tmask) << wlog2) + (FixedToInt(si) & smask)) * (bytes))
+
+#define TRI_SUB_STEP() si += dsi; ti += dti
+
+#define TRI_RGBA_STEP(span) \
+	span.red += span.redStep; \
+	span.green += span.greenStep; \
+	span.blue += span.blueStep; \
+	span.alpha += span.alphaStep
+
+/*
+ * Spans of the untextured triangles, with p the pixel of flat ones.
+ */
+#define TRI_FLAT_RENDER_SPAN(span) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	amesa_fill((GLubyte*) pRow, span.end * sizeof(GLuint), p);
+
+#define TRI_SMOOTH_RENDER_SPAN(span) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	for (GLuint i = 0; i < span.end; i++) { \
+		pRow[i] = RASTER_PACK(FixedToInt(span.red), FixedToInt(span.green), \
+				FixedToInt(span.blue), FixedToInt(span.alpha)); \
+		TRI_RGBA_STEP(span); \
+	}
+
+#define TRI_FLAT_Z_RENDER_SPAN(span) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	for (GLuint i = 0; i < span.end; i++) { \
+		const DEPTH_TYPE z = FixedToDepth(span.z); \
+		if (RASTER_Z_PASS(z, zRow[i])) { \
+			pRow[i] = p; \
+			zRow[i] = z; \
+		} \
+		span.z += span.zStep; \
+	}
+
+#define TRI_SMOOTH_Z_RENDER_SPAN(span) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	for (GLuint i = 0; i < span.end; i++) { \
+		const DEPTH_TYPE z = FixedToDepth(span.z); \
+		if (RASTER_Z_PASS(z, zRow[i])) { \
+			pRow[i] = RASTER_PACK(FixedToInt(span.red), FixedToInt(span.green), \
+					FixedToInt(span.blue), FixedToInt(span.alpha)); \
+			zRow[i] = z; \
+		} \
+		TRI_RGBA_STEP(span); \
+		span.z += span.zStep; \
+	}
+
+#define TRI_FLAT_PIXEL \
+	const GLuint p = RASTER_PACK(v2->color[RCOMP], v2->color[GCOMP], v2->color[BCOMP], v2->color[ACOMP]);
+
+/*
+ * Flat-shaded triangle, no depth test.
+ */
+#define NAME flat_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	TRI_FLAT_PIXEL
+#define RENDER_SPAN(span) TRI_FLAT_RENDER_SPAN(span)
+#include "swrast/s_tritemp.h"
+
+/*
+ * Smooth-shaded triangle, no depth test.
+ */
+#define NAME smooth_triangle
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP
+#define RENDER_SPAN(span) TRI_SMOOTH_RENDER_SPAN(span)
+#include "swrast/s_tritemp.h"
+
+/*
+ * Flat-shaded, depth-tested triangle.
+ */
+#define NAME flat_z_triangle
+#define INTERP_Z 1
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_FLAT_PIXEL
+#define RENDER_SPAN(span) TRI_FLAT_Z_RENDER_SPAN(span)
+#include "swrast/s_tritemp.h"
+
+/*
+ * Smooth-shaded, depth-tested triangle.
+ */
+#define NAME smooth_z_triangle
+#define INTERP_Z 1
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	RASTER_DEPTH_FUNC(a_ctx);
+#define RENDER_SPAN(span) TRI_SMOOTH_Z_RENDER_SPAN(span)
+#include "swrast/s_tritemp.h"
+
+/*
+ * Textured triangles.  GL_REPLACE with an RGB texture keeps the fragment
+ * alpha, GL_MODULATE with one modulates only the color.
+ */
+#define TRI_REPLACE_RGB(texel) \
+	RASTER_PACK(texel[0], texel[1], texel[2], FixedToInt(span.alpha))
+#define TRI_REPLACE_RGBA(texel) \
+	RASTER_PACK(texel[0], texel[1], texel[2], texel[3])
+#define TRI_MODULATE_RGB(texel) \
+	RASTER_PACK(TRI_PROD(texel[0], FixedToInt(span.red)), TRI_PROD(texel[1], FixedToInt(span.green)), \
+			TRI_PROD(texel[2], FixedToInt(span.blue)), FixedToInt(span.alpha))
+#define TRI_MODULATE_RGBA(texel) \
+	RASTER_PACK(TRI_PROD(texel[0], FixedToInt(span.red)), TRI_PROD(texel[1], FixedToInt(span.green)), \
+			TRI_PROD(texel[2], FixedToInt(span.blue)), TRI_PROD(texel[3], FixedToInt(span.alpha)))
+
+#define TRI_TEX_SUB_LOOP(span, bytes, texenv, tex) { \
+	TRI_SUB_SPAN(tex); \
+	for (GLuint i = 0; i < span.end; i++) { \
+		const GLchan *texel; \
+		TRI_SUB_CHUNK(tex, i); \
+		TRI_SUB_FETCH(texel, bytes); \
+		pRow[i] = texenv(texel); \
+		TRI_SUB_STEP(); \
+		TRI_RGBA_STEP(span); \
+	} \
+}
+
+#define TRI_TEX_Z_SUB_LOOP(span, bytes, texenv, tex) { \
+	TRI_SUB_SPAN(tex); \
+	for (GLuint i = 0; i < span.end; i++) { \
+		const DEPTH_TYPE z = FixedToDepth(span.z); \
+		TRI_SUB_CHUNK(tex, i); \
+		if (RASTER_Z_PASS(z, zRow[i])) { \
+			const GLchan *texel; \
+			TRI_SUB_FETCH(texel, bytes); \
+			pRow[i] = texenv(texel); \
+			zRow[i] = z; \
+		} \
+		TRI_SUB_STEP(); \
+		TRI_RGBA_STEP(span); \
+		span.z += span.zStep; \
+	} \
+}
+
+#define TRI_TEX_RENDER_SPAN(span, bytes, texenv, tex) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	tex##_SPAN(span); \
+	if (sub_shift) { \
+		TRI_TEX_SUB_LOOP(span, bytes, texenv, tex) \
+	} else { \
+		for (GLuint i = 0; i < span.end; i++) { \
+			const GLchan *texel; \
+			tex##_FETCH(texel, bytes); \
+			pRow[i] = texenv(texel); \
+			tex##_STEP(); \
+			TRI_RGBA_STEP(span); \
+		} \
+	}
+
+#define TRI_TEX_Z_RENDER_SPAN(span, bytes, texenv, tex) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	tex##_SPAN(span); \
+	if (sub_shift) { \
+		TRI_TEX_Z_SUB_LOOP(span, bytes, texenv, tex) \
+	} else { \
+		for (GLuint i = 0; i < span.end; i++) { \
+			const DEPTH_TYPE z = FixedToDepth(span.z); \
+			if (RASTER_Z_PASS(z, zRow[i])) { \
+				const GLchan *texel; \
+				tex##_FETCH(texel, bytes); \
+				pRow[i] = texenv(texel); \
+				zRow[i] = z; \
+			} \
+			tex##_STEP(); \
+			TRI_RGBA_STEP(span); \
+			span.z += span.zStep; \
+		} \
+	}
+
+/*
+ * The fixed-point triangles always go subdivided.
+ */
+#define TRI_FX_TEX_RENDER_SPAN(span, bytes, texenv) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	TRI_FX_TEX_SPAN(span); \
+	TRI_TEX_SUB_LOOP(span, bytes, texenv, TRI_FX_TEX)
+
+#define TRI_FX_TEX_Z_RENDER_SPAN(span, bytes, texenv) \
+	RASTER_TILES(a_ctx, span.x, span.y, span.end); \
+	TRI_FX_TEX_SPAN(span); \
+	TRI_TEX_Z_SUB_LOOP(span, bytes, texenv, TRI_FX_TEX)
+
+#define NAME tex_replace_rgb_triangle
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_RENDER_SPAN(span, 3, TRI_REPLACE_RGB, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_replace_rgba_triangle
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_RENDER_SPAN(span, 4, TRI_REPLACE_RGBA, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_modulate_rgb_triangle
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_RENDER_SPAN(span, 3, TRI_MODULATE_RGB, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_modulate_rgba_triangle
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_RENDER_SPAN(span, 4, TRI_MODULATE_RGBA, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_replace_rgb_z_triangle
+#define INTERP_Z 1
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_Z_RENDER_SPAN(span, 3, TRI_REPLACE_RGB, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_replace_rgba_z_triangle
+#define INTERP_Z 1
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_Z_RENDER_SPAN(span, 4, TRI_REPLACE_RGBA, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_modulate_rgb_z_triangle
+#define INTERP_Z 1
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_Z_RENDER_SPAN(span, 3, TRI_MODULATE_RGB, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+#define NAME tex_modulate_rgba_z_triangle
+#define INTERP_Z 1
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_TEX 1
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define BYTES_PER_ROW (a_ctx->draw_pitch)
+#define SETUP_CODE \
+	TRI_SETUP \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_TEX_SETUP_FLOAT
+#define RENDER_SPAN(span) TRI_TEX_Z_RENDER_SPAN(span, 4, TRI_MODULATE_RGBA, TRI_TEX)
+#include "swrast/s_tritemp.h"
+
+/*
+ * A span of the fixed-point triangles.  Color and depth are GLfixed and
+ * named like in swrast's spans, so both sets share the span code.
+ */
+struct fx_span {
+	GLint x, y;
+	GLuint end;
+	GLfixed z, zStep;
+	GLfixed red, redStep, green, greenStep, blue, blueStep, alpha, alphaStep;
+	GLint s, sStep, t, tStep, q, qStep; /* Texel coordinates times q, and q */
+};
+
+/*
+ * A float read from its bits as m * 2^e with m within 2^24 either way, so
+ * setting up texture coordinates needs no FPU.  0, denormals and anything
+ * not finite read as 0.
+ */
+static inline void fx_float(GLfloat f, GLint *m, GLint *e) {
+	GLuint bits;
+	GLint exp;
+
+	memcpy(&bits, &f, sizeof(bits));
+	exp = (bits >> 23) & 0xff;
+	if ((exp == 0) || (exp == 0xff)) {
+		*m = 0;
+		*e = 0;
+		return;
+	}
+
+	*m = (GLint) ((bits & 0x7fffff) | 0x800000);
+	if (bits & 0x80000000) {
+		*m = -*m;
+	}
+	*e = exp - 127 - 23;
+}
+
+/*
+ * A float above 0 that fx_float() does not read as 0, again from its bits.
+ */
+static inline GLboolean fx_positive(GLfloat f) {
+	GLuint bits;
+
+	memcpy(&bits, &f, sizeof(bits));
+	return (bits - 0x00800000) < 0x7f000000;
+}
+
+/*
+ * m * 2^e for m within 2^25 either way, saturated at 2^46.
+ */
+static inline long long fx_scale(long long m, GLint e) {
+	if (e > 21) {
+		return (m < 0) ? -(1LL << 46) : (m > 0) ? (1LL << 46) : 0;
+	} else if (e >= 0) {
+		return m * (1LL << e);
+	} else {
+		return (e > -63) ? (m >> -e) : ((m < 0) ? -1 : 0);
+	}
+}
+
+/*
+ * tri_begin() for vertices in 24.8 fixed point.
+ */
+static void fx_tri_begin(AMesaContext *a_ctx, GLint x1, GLint y1, GLint x2, GLint y2) {
+	const GLint x = MAX2(x1 >> 8, 0);
+	const GLint right = MIN2((x2 >> 8) + 1, (GLint) a_ctx->width);
+	const GLint row = MAX2((GLint) a_ctx->height - 1 - (y2 >> 8), 0);
+	const GLint bottom = MIN2((GLint) a_ctx->height - (y1 >> 8), (GLint) a_ctx->height);
+
+	amesa_display_draw_rect(a_ctx, x, row, right - x, bottom - row);
+}
+
+#define NAME fx_flat_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	TRI_FLAT_PIXEL
+#define RENDER_SPAN(span) TRI_FLAT_RENDER_SPAN(span)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_smooth_triangle
+#define INTERP_RGBA
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define RENDER_SPAN(span) TRI_SMOOTH_RENDER_SPAN(span)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_flat_z_triangle
+#define INTERP_Z
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_FLAT_PIXEL
+#define RENDER_SPAN(span) TRI_FLAT_Z_RENDER_SPAN(span)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_smooth_z_triangle
+#define INTERP_Z
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGBA
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	RASTER_DEPTH_FUNC(a_ctx);
+#define RENDER_SPAN(span) TRI_SMOOTH_Z_RENDER_SPAN(span)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_replace_rgb_triangle
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_replace_rgb_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_RENDER_SPAN(span, 3, TRI_REPLACE_RGB)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_replace_rgba_triangle
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_replace_rgba_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_RENDER_SPAN(span, 4, TRI_REPLACE_RGBA)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_modulate_rgb_triangle
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_modulate_rgb_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_RENDER_SPAN(span, 3, TRI_MODULATE_RGB)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_modulate_rgba_triangle
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_modulate_rgba_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_RENDER_SPAN(span, 4, TRI_MODULATE_RGBA)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_replace_rgb_z_triangle
+#define INTERP_Z
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_replace_rgb_z_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_Z_RENDER_SPAN(span, 3, TRI_REPLACE_RGB)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_replace_rgba_z_triangle
+#define INTERP_Z
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_replace_rgba_z_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_Z_RENDER_SPAN(span, 4, TRI_REPLACE_RGBA)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_modulate_rgb_z_triangle
+#define INTERP_Z
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_modulate_rgb_z_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_Z_RENDER_SPAN(span, 3, TRI_MODULATE_RGB)
+#include "amiga_mesa_fxtritmp.h"
+
+#define NAME fx_tex_modulate_rgba_z_triangle
+#define INTERP_Z
+#define DEPTH_TYPE DEFAULT_SOFTWARE_DEPTH_TYPE
+#define INTERP_RGBA
+#define INTERP_TEX
+#define S_LOG2 wlog2
+#define T_LOG2 hlog2
+#define TEX_FALLBACK tex_modulate_rgba_z_triangle
+#define PIXEL_TYPE GLuint
+#define PIXEL_ADDRESS(X, Y) TRI_PIXEL_ADDRESS(X, Y)
+#define SETUP_CODE \
+	RASTER_DEPTH_FUNC(a_ctx); \
+	TRI_FX_TEX_SETUP
+#define RENDER_SPAN(span) TRI_FX_TEX_Z_RENDER_SPAN(span, 4, TRI_MODULATE_RGBA)
+#include "amiga_mesa_fxtritmp.h"
+
+/*
+ * Triangle functions by shading or texture environment and format, without
+ * and with the depth test, in floating and in fixed point.
+ */
+enum tri_kind {
+	TRI_FLAT,
+	TRI_SMOOTH,
+	TRI_TEX_REPLACE_RGB,
+	TRI_TEX_REPLACE_RGBA,
+	TRI_TEX_MODULATE_RGB,
+	TRI_TEX_MODULATE_RGBA,
+	TRI_KINDS
+};
+
+static const swrast_tri_func triangle_funcs[2][TRI_KINDS][2] = {
+	{
+		{ flat_triangle, flat_z_triangle },
+		{ smooth_triangle, smooth_z_triangle },
+		{ tex_replace_rgb_triangle, tex_replace_rgb_z_triangle },
+		{ tex_replace_rgba_triangle, tex_replace_rgba_z_triangle },
+		{ tex_modulate_rgb_triangle, tex_modulate_rgb_z_triangle },
+		{ tex_modulate_rgba_triangle, tex_modulate_rgba_z_triangle }
+	},
+	{
+		{ fx_flat_triangle, fx_flat_z_triangle },
+		{ fx_smooth_triangle, fx_smooth_z_triangle },
+		{ fx_tex_replace_rgb_triangle, fx_tex_replace_rgb_z_triangle },
+		{ fx_tex_replace_rgba_triangle, fx_tex_replace_rgba_z_triangle },
+		{ fx_tex_modulate_rgb_triangle, fx_tex_modulate_rgb_z_triangle },
+		{ fx_tex_modulate_rgba_triangle, fx_tex_modulate_rgba_z_triangle }
+	}
+};
+
+/*
+ * The kind of triangle for texture 0, TRI_KINDS if it cannot be drawn by
+ * the driver.
+ */
+static enum tri_kind get_textured_triangle_kind(GLcontext *gl_ctx) {
+	const GLint format = raster_texture_format(gl_ctx);
+
+	if (format < 0) {
+		return TRI_KINDS;
+	}
+
+	if (gl_ctx->Texture.Unit[0].EnvMode == GL_REPLACE) {
+		return (format == MESA_FORMAT_RGB) ? TRI_TEX_REPLACE_RGB : TRI_TEX_REPLACE_RGBA;
+	} else {
+		return (format == MESA_FORMAT_RGB) ? TRI_TEX_MODULATE_RGB : TRI_TEX_MODULATE_RGBA;
+	}
+}
+
+/*
+ * The triangle function for the current state, NULL if swrast has to
+ * draw it.  Blending, fog, stencil, masking, clipping against the window
+ * and the like all go through swrast.
+ */
+static swrast_tri_func get_triangle_func(GLcontext *gl_ctx) {
+	AMesaContext *a_ctx = (AMesaContext*) gl_ctx->DriverCtx;
+	GLuint raster_mask = SWRAST_CONTEXT(gl_ctx)->_RasterMask;
+	const GLfloat bf = SWRAST_CONTEXT(gl_ctx)->_backface_sign;
+	GLboolean depth = GL_FALSE;
+	enum tri_kind kind;
+
+	if (!raster_usable(a_ctx) || gl_ctx->Polygon.SmoothFlag || gl_ctx->Polygon.StippleFlag) {
+		return NULL;
+	}
+
+	if (gl_ctx->Polygon.CullFlag && (gl_ctx->Polygon.CullFaceMode == GL_FRONT_AND_BACK)) {
+		return NULL;
+	}
+
+	if (raster_mask & DEPTH_BIT) {
+		if (!raster_depth_setup(a_ctx)) {
+			return NULL;
+		}
+		raster_mask &= ~DEPTH_BIT;
+		depth = GL_TRUE;
+	}
+
+	if (raster_mask & TEXTURE_BIT) {
+		if (raster_mask & ~TEXTURE_BIT) {
+			return NULL;
+		}
+		kind = get_textured_triangle_kind(gl_ctx);
+		if (kind == TRI_KINDS) {
+			return NULL;
+		}
+	} else if (raster_mask) {
+		return NULL;
+	} else {
+		kind = (gl_ctx->Light.ShadeModel == GL_SMOOTH) ? TRI_SMOOTH : TRI_FLAT;
+	}
+
+	// The fixed-point triangles cull themselves, swrast has just worked
+	// out which way.
+	a_ctx->cull_sign = (bf < 0.0F) ? -1 : (bf > 0.0F) ? 1 : 0;
+
+	// Textures are subdivided when asked for, or 16 pixels at a time when
+	// the application says it does not care.
+	if (a_ctx->tex_subdivide) {
+		a_ctx->subdiv_shift = (a_ctx->tex_subdivide == 8) ? 3 : 4;
+	} else if (gl_ctx->Hint.PerspectiveCorrection == GL_FASTEST) {
+		a_ctx->subdiv_shift = 4;
+	} else {
+		a_ctx->subdiv_shift = 0;
+	}
+
+	// The fixed-point triangles divide every 8 pixels at most, a divide
+	// per pixel is what they are there to avoid.
+	if (a_ctx->fixed_point && !a_ctx->subdiv_shift) {
+		a_ctx->subdiv_shift = 3;
+	}
+
+	return triangle_funcs[a_ctx->fixed_point ? 1 : 0][kind][depth ? 1 : 0];
+}
+
+/*
+ * swrast choose_triangle hook.
+ */
+void amesa_choose_triangle(GLcontext *gl_ctx) {
+	SWcontext *swrast = SWRAST_CONTEXT(gl_ctx);
+
+	if (!(swrast->Triangle = get_triangle_func(gl_ctx))) {
+		_swrast_choose_triangle(gl_ctx);
+	}
+}
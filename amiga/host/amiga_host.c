@@ -0,0 +1,869 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Host implementation of the AmigaOS stand-in declared in amiga_host.h.
+ *
+ * 32-bit pixels are handled as native ULONG words, so the word values the
+ * driver reads and writes are the same as on a big-endian Amiga no matter
+ * what the host byte order is.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "amiga_host.h"
+
+// Real CyberGraphX bitmaps are usually padded, so do the same here to
+// catch any code that assumes BytesPerRow == width * bpp.
+#define HOST_ROW_ALIGN 16
+
+#define HOST_DEFAULT_MODEID 0x50001000
+
+// The host always has floating point hardware.
+static struct ExecBase host_exec_base = {
+	AFF_68010 | AFF_68020 | AFF_68030 | AFF_68040 | AFF_68881 | AFF_68882 | AFF_FPU40
+};
+
+struct ExecBase *SysBase = &host_exec_base;
+
+APTR AllocVec(ULONG byteSize, ULONG requirements) {
+	if (requirements & MEMF_CLEAR) {
+		return calloc(1, byteSize);
+	}
+
+	return malloc(byteSize);
+}
+
+void FreeVec(APTR memoryBlock) {
+	free(memoryBlock);
+}
+
+void CopyMem(CONST_APTR source, APTR dest, ULONG size) {
+	memcpy(dest, source, size);
+}
+
+void CopyMemQuick(CONST_APTR source, APTR dest, ULONG size) {
+	memcpy(dest, source, size);
+}
+
+static struct Device host_timer_device;
+
+BYTE OpenDevice(const char *devName, ULONG unitNumber, struct IORequest *ioRequest, ULONG flags) {
+	// Only the timer E-clock unit is emulated.
+	if ((strcmp(devName, TIMERNAME) != 0) || (unitNumber != UNIT_ECLOCK)) {
+		ioRequest->io_Device = NULL;
+		ioRequest->io_Error = -1;
+		return -1;
+	}
+
+	host_timer_device.dd_OpenCnt++;
+	ioRequest->io_Device = &host_timer_device;
+	ioRequest->io_Error = 0;
+	return 0;
+}
+
+void CloseDevice(struct IORequest *ioRequest) {
+	if (ioRequest->io_Device) {
+		ioRequest->io_Device->dd_OpenCnt--;
+		ioRequest->io_Device = NULL;
+	}
+}
+
+/*
+ * Tasks are threads, so a port carries the lock and condition its
+ * messages are passed under.
+ */
+struct host_port {
+	struct MsgPort port;
+	pthread_mutex_t lock;
+	pthread_cond_t arrived;
+};
+
+struct MsgPort *CreateMsgPort(void) {
+	struct host_port *hp = (struct host_port*) calloc(1, sizeof(struct host_port));
+
+	if (!hp) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&hp->lock, NULL);
+	pthread_cond_init(&hp->arrived, NULL);
+	return &hp->port;
+}
+
+void DeleteMsgPort(struct MsgPort *port) {
+	struct host_port *hp = (struct host_port*) port;
+
+	if (hp) {
+		pthread_cond_destroy(&hp->arrived);
+		pthread_mutex_destroy(&hp->lock);
+		free(hp);
+	}
+}
+
+void PutMsg(struct MsgPort *port, struct Message *message) {
+	struct host_port *hp = (struct host_port*) port;
+
+	pthread_mutex_lock(&hp->lock);
+	message->mn_Node.ln_Succ = NULL;
+	if (port->mp_Tail) {
+		port->mp_Tail->mn_Node.ln_Succ = &message->mn_Node;
+	} else {
+		port->mp_Head = message;
+	}
+	port->mp_Tail = message;
+	pthread_cond_broadcast(&hp->arrived);
+	pthread_mutex_unlock(&hp->lock);
+}
+
+struct Message *GetMsg(struct MsgPort *port) {
+	struct host_port *hp = (struct host_port*) port;
+	struct Message *message;
+
+	pthread_mutex_lock(&hp->lock);
+	message = port->mp_Head;
+	if (message) {
+		port->mp_Head = (struct Message*) message->mn_Node.ln_Succ;
+		if (!port->mp_Head) {
+			port->mp_Tail = NULL;
+		}
+	}
+	pthread_mutex_unlock(&hp->lock);
+
+	return message;
+}
+
+struct Message *WaitPort(struct MsgPort *port) {
+	struct host_port *hp = (struct host_port*) port;
+	struct Message *message;
+
+	pthread_mutex_lock(&hp->lock);
+	while (!port->mp_Head) {
+		pthread_cond_wait(&hp->arrived, &hp->lock);
+	}
+	message = port->mp_Head;
+	pthread_mutex_unlock(&hp->lock);
+
+	return message;
+}
+
+void ReplyMsg(struct Message *message) {
+	if (message->mn_ReplyPort) {
+		PutMsg(message->mn_ReplyPort, message);
+	}
+}
+
+/*
+ * Forbid() can't stop other threads from running, it is a global lock
+ * instead.  That is enough for the one use the driver has for it: a task
+ * started under Forbid() does not run until Permit(), and a task that
+ * ends under Forbid() is gone before anyone else gets to run.
+ */
+static pthread_mutex_t host_forbid_lock;
+static pthread_once_t host_forbid_once = PTHREAD_ONCE_INIT;
+static __thread int host_forbid_count = 0;
+static __thread struct Task *host_this_task = NULL;
+static struct Task host_main_task;
+
+static void host_forbid_init(void) {
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&host_forbid_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+void Forbid(void) {
+	pthread_once(&host_forbid_once, host_forbid_init);
+	pthread_mutex_lock(&host_forbid_lock);
+	host_forbid_count++;
+}
+
+void Permit(void) {
+	if (host_forbid_count > 0) {
+		host_forbid_count--;
+		pthread_mutex_unlock(&host_forbid_lock);
+	}
+}
+
+struct Task *FindTask(const char *name) {
+	(void) name; // Only finding the current task is supported
+	return host_this_task ? host_this_task : &host_main_task;
+}
+
+struct host_task {
+	struct Task task;
+	void (*entry)(void);
+};
+
+static void *host_task_entry(void *data) {
+	struct host_task *ht = (struct host_task*) data;
+
+	host_this_task = &ht->task;
+
+	// Don't start before the creator's Permit().
+	Forbid();
+	Permit();
+
+	ht->entry();
+
+	// The task ended, which breaks any Forbid() it was in.
+	while (host_forbid_count > 0) {
+		Permit();
+	}
+
+	free(ht);
+	return NULL;
+}
+
+struct Task *CreateTask(const char *name, LONG pri, APTR initPC, ULONG stackSize) {
+	struct host_task *ht = (struct host_task*) calloc(1, sizeof(struct host_task));
+	pthread_attr_t attr;
+	pthread_t thread;
+	int error;
+
+	(void) name;
+	(void) pri;
+	(void) stackSize; // Host threads get the default stack, which is larger
+
+	if (!ht) {
+		return NULL;
+	}
+
+	ht->entry = (void (*)(void)) initPC;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	error = pthread_create(&thread, &attr, host_task_entry, ht);
+	pthread_attr_destroy(&attr);
+
+	if (error) {
+		free(ht);
+		return NULL;
+	}
+
+	return &ht->task;
+}
+
+IPTR GetTagData(Tag tagValue, IPTR defaultVal, const struct TagItem *tagList) {
+	while (tagList) {
+		switch (tagList->ti_Tag) {
+		case TAG_DONE:
+			return defaultVal;
+		case TAG_MORE:
+			tagList = (const struct TagItem*) tagList->ti_Data;
+			continue;
+		case TAG_SKIP:
+			tagList += tagList->ti_Data + 1;
+			continue;
+		default:
+			if (tagList->ti_Tag == tagValue) {
+				return tagList->ti_Data;
+			}
+			break;
+		}
+		tagList++;
+	}
+
+	return defaultVal;
+}
+
+/*
+ * The host E-clock ticks in microseconds.
+ */
+ULONG ReadEClock(struct EClockVal *dest) {
+	struct timespec ts;
+	uint64_t ticks;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ticks = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+	dest->ev_hi = (ULONG) (ticks >> 32);
+	dest->ev_lo = (ULONG) ticks;
+	return 1000000;
+}
+
+static ULONG host_bytes_per_pixel(ULONG pixfmt) {
+	switch (pixfmt) {
+	case PIXFMT_LUT8:
+		return 1;
+	case PIXFMT_RGB24:
+	case PIXFMT_BGR24:
+		return 3;
+	case PIXFMT_ARGB32:
+	case PIXFMT_BGRA32:
+	case PIXFMT_RGBA32:
+		return 4;
+	default:
+		return 2;
+	}
+}
+
+static ULONG host_depth_to_pixfmt(ULONG depth) {
+	switch (depth) {
+	case 8:
+		return PIXFMT_LUT8;
+	case 15:
+		return PIXFMT_RGB15;
+	case 16:
+		return PIXFMT_RGB16;
+	case 24:
+		return PIXFMT_RGB24;
+	default:
+		return PIXFMT_ARGB32;
+	}
+}
+
+struct BitMap *AllocBitMap(ULONG sizex, ULONG sizey, ULONG depth, ULONG flags, struct BitMap *friend_bitmap) {
+	struct BitMap *bm = (struct BitMap*) calloc(1, sizeof(struct BitMap));
+	if (!bm) {
+		return NULL;
+	}
+
+	if (flags & BMF_SPECIALFMT) {
+		bm->PixFmt = flags >> 24;
+	} else if (friend_bitmap) {
+		bm->PixFmt = friend_bitmap->PixFmt;
+	} else {
+		bm->PixFmt = host_depth_to_pixfmt(depth);
+	}
+
+	bm->BytesPerPixel = host_bytes_per_pixel(bm->PixFmt);
+	bm->BytesPerRow = (sizex * bm->BytesPerPixel + (HOST_ROW_ALIGN - 1)) & ~(HOST_ROW_ALIGN - 1);
+	bm->Width = sizex;
+	bm->Rows = sizey;
+
+	// Always cleared, BMF_CLEAR only makes a difference to the real thing.
+	bm->Memory = (UBYTE*) calloc(1, bm->BytesPerRow * sizey + HOST_ROW_ALIGN);
+	if (!bm->Memory) {
+		free(bm);
+		return NULL;
+	}
+
+	return bm;
+}
+
+void FreeBitMap(struct BitMap *bm) {
+	if (bm) {
+		free(bm->Memory);
+		free(bm);
+	}
+}
+
+void InitRastPort(struct RastPort *rp) {
+	memset(rp, 0, sizeof(struct RastPort));
+}
+
+ULONG GetVPModeID(struct ViewPort *vp) {
+	return vp->ModeID;
+}
+
+void WaitTOF(void) {
+}
+
+struct ScreenBuffer *AllocScreenBuffer(struct Screen *screen, struct BitMap *bitmap, ULONG flags) {
+	struct ScreenBuffer *buffer = (struct ScreenBuffer*) calloc(1, sizeof(struct ScreenBuffer));
+	struct BitMap *sbm = screen->RastPort.BitMap;
+
+	if (!buffer) {
+		return NULL;
+	}
+
+	buffer->sb_DBufInfo = (struct DBufInfo*) calloc(1, sizeof(struct DBufInfo));
+	if (!buffer->sb_DBufInfo) {
+		free(buffer);
+		return NULL;
+	}
+
+	if (flags & SB_SCREEN_BITMAP) {
+		buffer->sb_BitMap = sbm;
+	} else if (bitmap) {
+		buffer->sb_BitMap = bitmap;
+	} else {
+		buffer->sb_BitMap = AllocBitMap(sbm->Width, sbm->Rows, sbm->BytesPerPixel * 8,
+				BMF_DISPLAYABLE | BMF_SPECIALFMT | SHIFT_PIXFMT(sbm->PixFmt), sbm);
+		if (!buffer->sb_BitMap) {
+			free(buffer->sb_DBufInfo);
+			free(buffer);
+			return NULL;
+		}
+	}
+
+	if (flags & SB_COPY_BITMAP) {
+		memcpy(buffer->sb_BitMap->Memory, sbm->Memory, sbm->Rows * sbm->BytesPerRow);
+	}
+
+	return buffer;
+}
+
+void FreeScreenBuffer(struct Screen *screen, struct ScreenBuffer *buffer) {
+	if (buffer) {
+		if (buffer->sb_BitMap != screen->RastPort.BitMap) {
+			FreeBitMap(buffer->sb_BitMap);
+		}
+		free(buffer->sb_DBufInfo);
+		free(buffer);
+	}
+}
+
+/*
+ * There is no beam to wait for, so the old bitmap is safe to draw into as
+ * soon as the new one is on display.
+ */
+ULONG ChangeScreenBuffer(struct Screen *screen, struct ScreenBuffer *buffer) {
+	struct DBufInfo *dbi = buffer->sb_DBufInfo;
+
+	screen->ViewPort.BitMap = buffer->sb_BitMap;
+
+	if (dbi->dbi_DispMessage.mn_ReplyPort) {
+		PutMsg(dbi->dbi_DispMessage.mn_ReplyPort, &dbi->dbi_DispMessage);
+	}
+	if (dbi->dbi_SafeMessage.mn_ReplyPort) {
+		PutMsg(dbi->dbi_SafeMessage.mn_ReplyPort, &dbi->dbi_SafeMessage);
+	}
+
+	return 1;
+}
+
+BOOL IsCyberModeID(ULONG displayID) {
+	return (displayID == HOST_DEFAULT_MODEID);
+}
+
+ULONG GetCyberMapAttr(struct BitMap *bitMap, ULONG attribute) {
+	switch (attribute) {
+	case CYBRMATTR_XMOD:
+		return bitMap->BytesPerRow;
+	case CYBRMATTR_BPPIX:
+		return bitMap->BytesPerPixel;
+	case CYBRMATTR_PIXFMT:
+		return bitMap->PixFmt;
+	case CYBRMATTR_WIDTH:
+		return bitMap->Width;
+	case CYBRMATTR_HEIGHT:
+		return bitMap->Rows;
+	case CYBRMATTR_DEPTH:
+		if ((bitMap->PixFmt >= PIXFMT_RGB15) && (bitMap->PixFmt <= PIXFMT_BGR15PC)) {
+			return 15;
+		}
+		return bitMap->BytesPerPixel * 8;
+	case CYBRMATTR_ISCYBERGFX:
+	case CYBRMATTR_ISLINEARMEM:
+		return TRUE;
+	default:
+		// CYBRMATTR_DISPADR cannot be returned in a ULONG on a 64-bit host.
+		return 0;
+	}
+}
+
+/*
+ * 15/16-bit pixels are native words like the 32-bit ones, the PC formats
+ * have their bytes swapped and the BGR formats have blue in the high bits.
+ */
+static BOOL host_is_pc16(ULONG pixfmt) {
+	return (pixfmt == PIXFMT_RGB15PC) || (pixfmt == PIXFMT_BGR15PC) ||
+			(pixfmt == PIXFMT_RGB16PC) || (pixfmt == PIXFMT_BGR16PC);
+}
+
+static BOOL host_is_bgr16(ULONG pixfmt) {
+	return (pixfmt == PIXFMT_BGR15) || (pixfmt == PIXFMT_BGR15PC) ||
+			(pixfmt == PIXFMT_BGR16) || (pixfmt == PIXFMT_BGR16PC);
+}
+
+static BOOL host_is_15bit(ULONG pixfmt) {
+	return (pixfmt >= PIXFMT_RGB15) && (pixfmt <= PIXFMT_BGR15PC);
+}
+
+static ULONG host_get_pixel16(UWORD p, ULONG pixfmt) {
+	ULONG hi, g, lo;
+
+	if (host_is_pc16(pixfmt)) {
+		p = (UWORD) ((p >> 8) | (p << 8));
+	}
+
+	if (host_is_15bit(pixfmt)) {
+		hi = (p >> 10) & 0x1f;
+		g = (p >> 5) & 0x1f;
+		g = (g << 3) | (g >> 2);
+	} else {
+		hi = (p >> 11) & 0x1f;
+		g = (p >> 5) & 0x3f;
+		g = (g << 2) | (g >> 4);
+	}
+	lo = p & 0x1f;
+	hi = (hi << 3) | (hi >> 2);
+	lo = (lo << 3) | (lo >> 2);
+
+	if (host_is_bgr16(pixfmt)) {
+		return 0xff000000 | (lo << 16) | (g << 8) | hi;
+	}
+	return 0xff000000 | (hi << 16) | (g << 8) | lo;
+}
+
+static UWORD host_put_pixel16(ULONG argb, ULONG pixfmt) {
+	ULONG r = (argb >> 16) & 0xff;
+	ULONG g = (argb >> 8) & 0xff;
+	ULONG b = argb & 0xff;
+	ULONG hi = host_is_bgr16(pixfmt) ? b : r;
+	ULONG lo = host_is_bgr16(pixfmt) ? r : b;
+	UWORD p;
+
+	if (host_is_15bit(pixfmt)) {
+		p = (UWORD) (((hi & 0xf8) << 7) | ((g & 0xf8) << 2) | (lo >> 3));
+	} else {
+		p = (UWORD) (((hi & 0xf8) << 8) | ((g & 0xfc) << 3) | (lo >> 3));
+	}
+
+	if (host_is_pc16(pixfmt)) {
+		p = (UWORD) ((p >> 8) | (p << 8));
+	}
+	return p;
+}
+
+/*
+ * Fetch one pixel of the given bitmap format as an 0xAARRGGBB word.
+ */
+static ULONG host_get_pixel(const UBYTE *src, ULONG pixfmt) {
+	ULONG p;
+
+	switch (pixfmt) {
+	case PIXFMT_RGB24:
+		return 0xff000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+	case PIXFMT_BGR24:
+		return 0xff000000 | (src[2] << 16) | (src[1] << 8) | src[0];
+	case PIXFMT_BGRA32:
+		p = *(const ULONG*) src;
+		return ((p & 0xff) << 24) | ((p >> 8) & 0xff) << 16 | ((p >> 16) & 0xff) << 8 | (p >> 24);
+	case PIXFMT_RGBA32:
+		p = *(const ULONG*) src;
+		return (p >> 8) | (p << 24);
+	case PIXFMT_ARGB32:
+		return *(const ULONG*) src;
+	case PIXFMT_RGB16:
+	case PIXFMT_BGR16:
+	case PIXFMT_RGB16PC:
+	case PIXFMT_BGR16PC:
+	case PIXFMT_RGB15:
+	case PIXFMT_BGR15:
+	case PIXFMT_RGB15PC:
+	case PIXFMT_BGR15PC:
+		return host_get_pixel16(*(const UWORD*) src, pixfmt);
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Store an 0xAARRGGBB word as one pixel of the given bitmap format.
+ */
+static void host_put_pixel(UBYTE *dst, ULONG pixfmt, ULONG argb) {
+	ULONG a = (argb >> 24) & 0xff;
+	ULONG r = (argb >> 16) & 0xff;
+	ULONG g = (argb >> 8) & 0xff;
+	ULONG b = argb & 0xff;
+
+	switch (pixfmt) {
+	case PIXFMT_RGB24:
+		dst[0] = r;
+		dst[1] = g;
+		dst[2] = b;
+		break;
+	case PIXFMT_BGR24:
+		dst[0] = b;
+		dst[1] = g;
+		dst[2] = r;
+		break;
+	case PIXFMT_BGRA32:
+		*(ULONG*) dst = (b << 24) | (g << 16) | (r << 8) | a;
+		break;
+	case PIXFMT_RGBA32:
+		*(ULONG*) dst = (r << 24) | (g << 16) | (b << 8) | a;
+		break;
+	case PIXFMT_ARGB32:
+		*(ULONG*) dst = argb;
+		break;
+	case PIXFMT_RGB16:
+	case PIXFMT_BGR16:
+	case PIXFMT_RGB16PC:
+	case PIXFMT_BGR16PC:
+	case PIXFMT_RGB15:
+	case PIXFMT_BGR15:
+	case PIXFMT_RGB15PC:
+	case PIXFMT_BGR15PC:
+		*(UWORD*) dst = host_put_pixel16(argb, pixfmt);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Fetch one pixel of a RECTFMT_xxx source as an 0xAARRGGBB word.
+ */
+static ULONG host_get_rect_pixel(const UBYTE *src, UBYTE rectfmt) {
+	switch (rectfmt) {
+	case RECTFMT_RGB:
+		return host_get_pixel(src, PIXFMT_RGB24);
+	case RECTFMT_RGBA:
+		return host_get_pixel(src, PIXFMT_RGBA32);
+	case RECTFMT_GREY8:
+		return 0xff000000 | (src[0] << 16) | (src[0] << 8) | src[0];
+	default: // RECTFMT_ARGB
+		return host_get_pixel(src, PIXFMT_ARGB32);
+	}
+}
+
+static void host_put_rect_pixel(UBYTE *dst, UBYTE rectfmt, ULONG argb) {
+	switch (rectfmt) {
+	case RECTFMT_RGB:
+		host_put_pixel(dst, PIXFMT_RGB24, argb);
+		break;
+	case RECTFMT_RGBA:
+		host_put_pixel(dst, PIXFMT_RGBA32, argb);
+		break;
+	case RECTFMT_GREY8:
+		dst[0] = (((argb >> 16) & 0xff) + ((argb >> 8) & 0xff) + (argb & 0xff)) / 3;
+		break;
+	default: // RECTFMT_ARGB
+		host_put_pixel(dst, PIXFMT_ARGB32, argb);
+		break;
+	}
+}
+
+static ULONG host_rect_bytes_per_pixel(UBYTE rectfmt, struct BitMap *bm) {
+	switch (rectfmt) {
+	case RECTFMT_RGB:
+		return 3;
+	case RECTFMT_LUT8:
+	case RECTFMT_GREY8:
+		return 1;
+	case RECTFMT_RAW:
+		return bm->BytesPerPixel;
+	default:
+		return 4;
+	}
+}
+
+/*
+ * Clip a rectangle against the bitmap, returns FALSE when nothing is left.
+ */
+static BOOL host_clip(struct BitMap *bm, UWORD x, UWORD y, UWORD *sizeX, UWORD *sizeY) {
+	if ((x >= bm->Width) || (y >= bm->Rows)) {
+		return FALSE;
+	}
+
+	if (x + *sizeX > bm->Width) {
+		*sizeX = bm->Width - x;
+	}
+
+	if (y + *sizeY > bm->Rows) {
+		*sizeY = bm->Rows - y;
+	}
+
+	return (*sizeX > 0) && (*sizeY > 0);
+}
+
+/*
+ * A rectangle format that matches the bitmap layout is copied as is.
+ */
+static BOOL host_rect_is_raw(UBYTE rectfmt, struct BitMap *bm) {
+	return (rectfmt == RECTFMT_RAW) ||
+			((rectfmt == RECTFMT_ARGB) && (bm->PixFmt == PIXFMT_ARGB32)) ||
+			((rectfmt == RECTFMT_RGBA) && (bm->PixFmt == PIXFMT_RGBA32));
+}
+
+ULONG WritePixelArray(APTR srcRect, UWORD srcX, UWORD srcY, UWORD srcMod, struct RastPort *rp,
+		UWORD destX, UWORD destY, UWORD sizeX, UWORD sizeY, UBYTE srcFormat) {
+	struct BitMap *bm = rp->BitMap;
+	ULONG src_bpp = host_rect_bytes_per_pixel(srcFormat, bm);
+
+	if (!host_clip(bm, destX, destY, &sizeX, &sizeY)) {
+		return 0;
+	}
+
+	for (UWORD row = 0; row < sizeY; row++) {
+		const UBYTE *src = (const UBYTE*) srcRect + (srcY + row) * srcMod + srcX * src_bpp;
+		UBYTE *dst = bm->Memory + (destY + row) * bm->BytesPerRow + destX * bm->BytesPerPixel;
+
+		if (host_rect_is_raw(srcFormat, bm)) {
+			memcpy(dst, src, sizeX * bm->BytesPerPixel);
+		} else {
+			for (UWORD col = 0; col < sizeX; col++) {
+				host_put_pixel(dst, bm->PixFmt, host_get_rect_pixel(src, srcFormat));
+				src += src_bpp;
+				dst += bm->BytesPerPixel;
+			}
+		}
+	}
+
+	return (ULONG) sizeX * sizeY;
+}
+
+ULONG FillPixelArray(struct RastPort *rp, UWORD destX, UWORD destY, UWORD sizeX, UWORD sizeY, ULONG ARGB) {
+	struct BitMap *bm = rp->BitMap;
+
+	if (!host_clip(bm, destX, destY, &sizeX, &sizeY)) {
+		return 0;
+	}
+
+	for (UWORD row = 0; row < sizeY; row++) {
+		UBYTE *dst = bm->Memory + (destY + row) * bm->BytesPerRow + destX * bm->BytesPerPixel;
+
+		for (UWORD col = 0; col < sizeX; col++) {
+			host_put_pixel(dst, bm->PixFmt, ARGB);
+			dst += bm->BytesPerPixel;
+		}
+	}
+
+	return (ULONG) sizeX * sizeY;
+}
+
+ULONG ReadPixelArray(APTR destRect, UWORD destX, UWORD destY, UWORD destMod, struct RastPort *rp,
+		UWORD srcX, UWORD srcY, UWORD sizeX, UWORD sizeY, UBYTE destFormat) {
+	struct BitMap *bm = rp->BitMap;
+	ULONG dst_bpp = host_rect_bytes_per_pixel(destFormat, bm);
+
+	if (!host_clip(bm, srcX, srcY, &sizeX, &sizeY)) {
+		return 0;
+	}
+
+	for (UWORD row = 0; row < sizeY; row++) {
+		const UBYTE *src = bm->Memory + (srcY + row) * bm->BytesPerRow + srcX * bm->BytesPerPixel;
+		UBYTE *dst = (UBYTE*) destRect + (destY + row) * destMod + destX * dst_bpp;
+
+		if (host_rect_is_raw(destFormat, bm)) {
+			memcpy(dst, src, sizeX * bm->BytesPerPixel);
+		} else {
+			for (UWORD col = 0; col < sizeX; col++) {
+				host_put_rect_pixel(dst, destFormat, host_get_pixel(src, bm->PixFmt));
+				src += bm->BytesPerPixel;
+				dst += dst_bpp;
+			}
+		}
+	}
+
+	return (ULONG) sizeX * sizeY;
+}
+
+/*
+ * Bitmaps live in plain memory, so a lock just hands out the base address.
+ * The lock count lets the host catch unbalanced lock/unlock pairs.
+ */
+APTR LockBitMapTags(APTR handle, Tag tag1, ...) {
+	struct BitMap *bm = (struct BitMap*) handle;
+	va_list args;
+	Tag tag;
+
+	if (!bm || (bm->LockCount > 0)) {
+		return NULL;
+	}
+
+	va_start(args, tag1);
+	for (tag = tag1; tag != TAG_DONE; tag = va_arg(args, Tag)) {
+		void *data = va_arg(args, void*);
+
+		switch (tag) {
+		case LBMI_BASEADDRESS:
+			*(APTR*) data = bm->Memory;
+			break;
+		case LBMI_BYTESPERROW:
+			*(ULONG*) data = bm->BytesPerRow;
+			break;
+		case LBMI_BYTESPERPIX:
+			*(ULONG*) data = bm->BytesPerPixel;
+			break;
+		case LBMI_PIXFMT:
+			*(ULONG*) data = bm->PixFmt;
+			break;
+		case LBMI_WIDTH:
+			*(ULONG*) data = bm->Width;
+			break;
+		case LBMI_HEIGHT:
+			*(ULONG*) data = bm->Rows;
+			break;
+		case LBMI_DEPTH:
+			*(ULONG*) data = GetCyberMapAttr(bm, CYBRMATTR_DEPTH);
+			break;
+		}
+	}
+	va_end(args);
+
+	bm->LockCount++;
+	return bm;
+}
+
+void UnLockBitMap(APTR handle) {
+	struct BitMap *bm = (struct BitMap*) handle;
+
+	if (bm && (bm->LockCount > 0)) {
+		bm->LockCount--;
+	}
+}
+
+struct Window *amiga_host_open_window(UWORD width, UWORD height, ULONG pixfmt) {
+	struct Screen *screen;
+	struct Window *window;
+
+	screen = (struct Screen*) calloc(1, sizeof(struct Screen));
+	window = (struct Window*) calloc(1, sizeof(struct Window));
+	if (!screen || !window) {
+		free(screen);
+		free(window);
+		return NULL;
+	}
+
+	// Give the window real borders so the border offsets get exercised.
+	window->BorderLeft = 4;
+	window->BorderTop = 11;
+	window->BorderRight = 4;
+	window->BorderBottom = 2;
+	window->Width = width + window->BorderLeft + window->BorderRight;
+	window->Height = height + window->BorderTop + window->BorderBottom;
+
+	screen->Width = window->Width;
+	screen->Height = window->Height;
+	screen->ViewPort.ModeID = HOST_DEFAULT_MODEID;
+	screen->RastPort.BitMap = AllocBitMap(screen->Width, screen->Height, 32,
+			BMF_CLEAR | BMF_DISPLAYABLE | BMF_SPECIALFMT | SHIFT_PIXFMT(pixfmt), NULL);
+	if (!screen->RastPort.BitMap) {
+		free(screen);
+		free(window);
+		return NULL;
+	}
+
+	screen->ViewPort.BitMap = screen->RastPort.BitMap;
+
+	window->WScreen = screen;
+	window->RPort = &screen->RastPort;
+	return window;
+}
+
+void amiga_host_close_window(struct Window *window) {
+	if (window) {
+		FreeBitMap(window->WScreen->RastPort.BitMap);
+		free(window->WScreen);
+		free(window);
+	}
+}
@@ -0,0 +1,318 @@
+/* $Id: $ */
+
+/*
+ * Mesa 3-D graphics library
+ * Copyright (C) 1995  Brian Paul  (brianp@ssec.wisc.edu)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Host stand-in for the small part of exec, graphics, intuition and
+ * cybergraphics that the Amiga driver uses.
+ *
+ * This lets the unmodified driver sources be built and profiled on a
+ * non-Amiga host (define AMIGA and AMESA_HOST, and put this directory
+ * first on the include path).  Bitmaps are plain memory surfaces in one
+ * of the CyberGraphX pixel formats and WritePixelArray() performs the
+ * same format conversion the real library would.
+ */
+
+#ifndef AMIGA_HOST_H
+#define AMIGA_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* exec/types.h */
+typedef void *APTR;
+typedef const void *CONST_APTR;
+typedef uint32_t ULONG;
+typedef int32_t LONG;
+typedef uint16_t UWORD;
+typedef int16_t WORD;
+typedef uint8_t UBYTE;
+typedef int8_t BYTE;
+typedef int16_t BOOL;
+typedef char *STRPTR;
+typedef uintptr_t IPTR; /* Tag data must be able to hold a pointer */
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/* exec/memory.h */
+#define MEMF_ANY    (0L)
+#define MEMF_PUBLIC (1L << 0)
+#define MEMF_CHIP   (1L << 1)
+#define MEMF_FAST   (1L << 2)
+#define MEMF_CLEAR  (1L << 16)
+
+/* exec/nodes.h, exec/ports.h */
+struct Node {
+	struct Node *ln_Succ;
+	struct Node *ln_Pred;
+};
+
+struct Message {
+	struct Node mn_Node;
+	struct MsgPort *mn_ReplyPort;
+	UWORD mn_Length;
+};
+
+struct MsgPort {
+	struct Message *mp_Head; /* Queued messages, oldest first */
+	struct Message *mp_Tail;
+};
+
+/* exec/tasks.h */
+struct Task {
+	struct Node tc_Node;
+	APTR tc_UserData;
+};
+
+/* exec/execbase.h */
+struct ExecBase {
+	UWORD AttnFlags; /* CPU and FPU present */
+};
+
+#define AFF_68010 (1L << 0)
+#define AFF_68020 (1L << 1)
+#define AFF_68030 (1L << 2)
+#define AFF_68040 (1L << 3)
+#define AFF_68881 (1L << 4)
+#define AFF_68882 (1L << 5)
+#define AFF_FPU40 (1L << 6)
+
+extern struct ExecBase *SysBase;
+
+/* utility/tagitem.h */
+typedef ULONG Tag;
+
+struct TagItem {
+	Tag ti_Tag;
+	IPTR ti_Data;
+};
+
+#define TAG_DONE   0 /* Plain int so it is safe as a varargs terminator */
+#define TAG_END    0
+#define TAG_IGNORE (1L)
+#define TAG_MORE   (2L)
+#define TAG_SKIP   (3L)
+#define TAG_USER   ((ULONG)(1UL << 31))
+
+/* graphics/gfx.h */
+struct BitMap {
+	ULONG BytesPerRow;
+	ULONG Width;
+	ULONG Rows;
+	ULONG PixFmt;
+	ULONG BytesPerPixel;
+	UBYTE *Memory;
+	LONG LockCount;
+};
+
+#define BMF_CLEAR       (1L << 0)
+#define BMF_DISPLAYABLE (1L << 1)
+#define BMF_INTERLEAVED (1L << 2)
+#define BMF_STANDARD    (1L << 3)
+#define BMF_MINPLANES   (1L << 4)
+
+/* graphics/rastport.h */
+struct RastPort {
+	struct BitMap *BitMap;
+};
+
+/* graphics/view.h */
+struct ViewPort {
+	ULONG ModeID;
+	struct BitMap *BitMap; /* Stands in for RasInfo->BitMap, the bitmap on display */
+};
+
+/* intuition/screens.h */
+struct Screen {
+	WORD Width, Height;
+	struct ViewPort ViewPort;
+	struct RastPort RastPort;
+};
+
+/* intuition/screens.h */
+struct DBufInfo {
+	APTR dbi_Link1;
+	ULONG dbi_Count1;
+	struct Message dbi_SafeMessage; /* Replied when the old bitmap is safe to draw into */
+	APTR dbi_UserData1;
+	APTR dbi_Link2;
+	ULONG dbi_Count2;
+	struct Message dbi_DispMessage; /* Replied when the new bitmap is on display */
+	APTR dbi_UserData2;
+};
+
+struct ScreenBuffer {
+	struct BitMap *sb_BitMap;
+	struct DBufInfo *sb_DBufInfo;
+};
+
+#define SB_SCREEN_BITMAP 1
+#define SB_COPY_BITMAP   2
+
+/* intuition/intuition.h */
+struct Window {
+	WORD LeftEdge, TopEdge;
+	WORD Width, Height;
+	BYTE BorderLeft, BorderTop, BorderRight, BorderBottom;
+	struct RastPort *RPort;
+	struct Screen *WScreen;
+};
+
+/* exec/devices.h, exec/io.h */
+struct Device {
+	ULONG dd_OpenCnt;
+};
+
+struct IORequest {
+	struct Device *io_Device;
+	BYTE io_Error;
+};
+
+/* devices/timer.h */
+#define TIMERNAME "timer.device"
+
+#define UNIT_MICROHZ 0
+#define UNIT_VBLANK  1
+#define UNIT_ECLOCK  2
+
+struct timerequest {
+	struct IORequest tr_node;
+};
+
+struct EClockVal {
+	ULONG ev_hi;
+	ULONG ev_lo;
+};
+
+/* cybergraphics/cybergraphics.h */
+#define CYBRMATTR_XMOD        (0x80000001)
+#define CYBRMATTR_BPPIX       (0x80000002)
+#define CYBRMATTR_DISPADR     (0x80000003)
+#define CYBRMATTR_PIXFMT      (0x80000004)
+#define CYBRMATTR_WIDTH       (0x80000005)
+#define CYBRMATTR_HEIGHT      (0x80000006)
+#define CYBRMATTR_DEPTH       (0x80000007)
+#define CYBRMATTR_ISCYBERGFX  (0x80000008)
+#define CYBRMATTR_ISLINEARMEM (0x80000009)
+
+#define PIXFMT_LUT8    (0UL)
+#define PIXFMT_RGB15   (1UL)
+#define PIXFMT_BGR15   (2UL)
+#define PIXFMT_RGB15PC (3UL)
+#define PIXFMT_BGR15PC (4UL)
+#define PIXFMT_RGB16   (5UL)
+#define PIXFMT_BGR16   (6UL)
+#define PIXFMT_RGB16PC (7UL)
+#define PIXFMT_BGR16PC (8UL)
+#define PIXFMT_RGB24   (9UL)
+#define PIXFMT_BGR24   (10UL)
+#define PIXFMT_ARGB32  (11UL)
+#define PIXFMT_BGRA32  (12UL)
+#define PIXFMT_RGBA32  (13UL)
+
+#define LBMI_WIDTH       (0x84001001)
+#define LBMI_HEIGHT      (0x84001002)
+#define LBMI_DEPTH       (0x84001003)
+#define LBMI_PIXFMT      (0x84001004)
+#define LBMI_BYTESPERPIX (0x84001005)
+#define LBMI_BYTESPERROW (0x84001006)
+#define LBMI_BASEADDRESS (0x84001007)
+
+#define RECTFMT_RGB   (0UL)
+#define RECTFMT_RGBA  (1UL)
+#define RECTFMT_ARGB  (2UL)
+#define RECTFMT_LUT8  (3UL)
+#define RECTFMT_GREY8 (4UL)
+#define RECTFMT_RAW   (5UL)
+
+#define BMB_SPECIALFMT 7
+#define BMF_SPECIALFMT (1UL << BMB_SPECIALFMT)
+#define SHIFT_PIXFMT(fmt) (((ULONG)(fmt)) << 24UL)
+
+/* exec.library */
+APTR AllocVec(ULONG byteSize, ULONG requirements);
+void FreeVec(APTR memoryBlock);
+void CopyMem(CONST_APTR source, APTR dest, ULONG size);
+void CopyMemQuick(CONST_APTR source, APTR dest, ULONG size);
+BYTE OpenDevice(const char *devName, ULONG unitNumber, struct IORequest *ioRequest, ULONG flags);
+void CloseDevice(struct IORequest *ioRequest);
+struct MsgPort *CreateMsgPort(void);
+void DeleteMsgPort(struct MsgPort *port);
+void PutMsg(struct MsgPort *port, struct Message *message);
+struct Message *GetMsg(struct MsgPort *port);
+struct Message *WaitPort(struct MsgPort *port);
+void ReplyMsg(struct Message *message);
+struct Task *FindTask(const char *name);
+void Forbid(void);
+void Permit(void);
+
+/* amiga.lib */
+struct Task *CreateTask(const char *name, LONG pri, APTR initPC, ULONG stackSize);
+
+/* utility.library */
+IPTR GetTagData(Tag tagValue, IPTR defaultVal, const struct TagItem *tagList);
+
+/* timer.device */
+ULONG ReadEClock(struct EClockVal *dest);
+
+/* graphics.library */
+struct BitMap *AllocBitMap(ULONG sizex, ULONG sizey, ULONG depth, ULONG flags, struct BitMap *friend_bitmap);
+void FreeBitMap(struct BitMap *bm);
+void InitRastPort(struct RastPort *rp);
+ULONG GetVPModeID(struct ViewPort *vp);
+void WaitTOF(void);
+
+/* intuition.library */
+struct ScreenBuffer *AllocScreenBuffer(struct Screen *screen, struct BitMap *bitmap, ULONG flags);
+void FreeScreenBuffer(struct Screen *screen, struct ScreenBuffer *buffer);
+ULONG ChangeScreenBuffer(struct Screen *screen, struct ScreenBuffer *buffer);
+
+/* cybergraphics.library */
+BOOL IsCyberModeID(ULONG displayID);
+ULONG GetCyberMapAttr(struct BitMap *bitMap, ULONG attribute);
+ULONG WritePixelArray(APTR srcRect, UWORD srcX, UWORD srcY, UWORD srcMod, struct RastPort *rp,
+		UWORD destX, UWORD destY, UWORD sizeX, UWORD sizeY, UBYTE srcFormat);
+ULONG FillPixelArray(struct RastPort *rp, UWORD destX, UWORD destY, UWORD sizeX, UWORD sizeY, ULONG ARGB);
+ULONG ReadPixelArray(APTR destRect, UWORD destX, UWORD destY, UWORD destMod, struct RastPort *rp,
+		UWORD srcX, UWORD srcY, UWORD sizeX, UWORD sizeY, UBYTE destFormat);
+APTR LockBitMapTags(APTR handle, Tag tag1, ...);
+void UnLockBitMap(APTR handle);
+
+/*
+ * Host-only helpers, used to stand up a window on a memory surface so
+ * the windowed code path can be exercised without Intuition.
+ */
+struct Window *amiga_host_open_window(UWORD width, UWORD height, ULONG pixfmt);
+void amiga_host_close_window(struct Window *window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in, see amiga_host.h */
+#ifndef HOST_CLIB_ALIB_PROTOS_H
+#define HOST_CLIB_ALIB_PROTOS_H
+
+#include <amiga_host.h>
+
+#endif
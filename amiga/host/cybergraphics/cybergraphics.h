@@ -0,0 +1,7 @@
+/* Host stand-in, see amiga_host.h */
+#ifndef HOST_CYBERGRAPHICS_CYBERGRAPHICS_H
+#define HOST_CYBERGRAPHICS_CYBERGRAPHICS_H
+
+#include <amiga_host.h>
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in, see amiga_host.h */
+#ifndef HOST_DEVICES_TIMER_H
+#define HOST_DEVICES_TIMER_H
+
+#include <amiga_host.h>
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in, see amiga_host.h */
+#ifndef HOST_EXEC_EXECBASE_H
+#define HOST_EXEC_EXECBASE_H
+
+#include <amiga_host.h>
+
+#endif
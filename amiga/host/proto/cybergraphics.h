@@ -0,0 +1,7 @@
+/* Host stand-in, see amiga_host.h */
+#ifndef HOST_PROTO_CYBERGRAPHICS_H
+#define HOST_PROTO_CYBERGRAPHICS_H
+
+#include <amiga_host.h>
+
+#endif